@@ -3,7 +3,11 @@
 
 #include "common.h"
 
-void aStarInit(u64 capacity);
+#include "priority_queue.h"
+
+// use_landmarks: bound the cost left with the landmark tables as well (ALT),
+// built first when the map changed since the last build
+void aStarInit(u64 capacity, PriorityQueueKind queue, b8 use_landmarks);
 void aStarStep(void);
 
 b8  aStarShouldStop(void);
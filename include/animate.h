@@ -3,7 +3,23 @@
 
 #include "common.h"
 
-void buildAnimationPath(void* cell);
+#include "search_path.h"
+
+// Queues a cell of the solution, from the start to the goal, as the search
+// worker publishes them. animateStart() then draws one per frame.
+void animateAddCell(u32 cell);
+void animateStart(void);
 void animatePath(void);
 
-#endif // PF_ANIMATE_H
\ No newline at end of file
+// Forgets the path shown so far
+void animateClear(void);
+// Also frees the path buffer, which animateClear() keeps for the next path
+void animateDestroy(void);
+b8   animateIsOnPath(u32 cell);
+
+// Cells shown as the solution so far, 1 bit per cell, NULL when there are none
+const u64* animateGetPathCells(void);
+// The whole solution, drawn or not yet
+const SearchPath* animateGetPath(void);
+
+#endif // PF_ANIMATE_H
@@ -0,0 +1,27 @@
+#ifndef PF_BFS_PARALLEL_H
+#define PF_BFS_PARALLEL_H
+
+#include "common.h"
+
+#include "grid.h"
+
+// Level-synchronous BFS: every step expands a whole frontier level, split
+// across a pool of threads. Small frontiers are expanded top-down (each
+// frontier cell claims its unvisited neighbors with an atomic bit set); once
+// the frontier is large compared to the cells still unreached, the level is
+// expanded bottom-up instead (each unreached cell looks for a neighbor in the
+// frontier). Both give every cell its BFS distance, only the parent chosen
+// among equally distant neighbors can differ from the serial BFS.
+//
+// threads: 0 uses one thread per online core.
+void bfsParallelInit(u32 threads);
+void bfsParallelStep(void);
+
+b8  bfsParallelShouldStop(void);
+
+// Hop distance from source to every cell (GRID_INFINITY if unreachable),
+// for reachability and distance-map jobs. parent may be NULL. Reads the moves
+// of the grid, which gridBuildMoves() must have built.
+void bfsParallelDistanceMap(const Grid* grid, u32 source, u32* distance, u32* parent, u32 threads);
+
+#endif // PF_BFS_PARALLEL_H
@@ -0,0 +1,20 @@
+#ifndef PF_BIDIRECTIONAL_H
+#define PF_BIDIRECTIONAL_H
+
+#include "common.h"
+
+#include "priority_queue.h"
+#include "search.h"
+
+// Grows one search from the start and one from the goal. base is ALGO_BFS,
+// ALGO_DIJKSTRA or ALGO_ASTAR.
+//
+// The forward side uses the grid's distance and parent arrays. Once the two
+// sides meet, the backward half of the path is written into parent[], so the
+// path reads from the goal back to the start like it does for a one-sided search.
+void bidirInit(SearchAlgo base, u64 capacity, PriorityQueueKind queue);
+void bidirStep(void);
+
+b8  bidirShouldStop(void);
+
+#endif // PF_BIDIRECTIONAL_H
@@ -0,0 +1,27 @@
+#ifndef PF_DELTA_STEPPING_H
+#define PF_DELTA_STEPPING_H
+
+#include "common.h"
+
+#include "grid.h"
+
+// Delta-stepping (Meyer and Sanders): tentative distances are kept in buckets
+// of width delta. Each step settles the smallest bucket: the light edges
+// (entering weight <= delta) of all its cells are relaxed in parallel until
+// the bucket stops changing, then the heavy edges of the cells it settled.
+// Distances are the same as Dijkstra's, only the parent chosen among equally
+// short paths can differ.
+//
+// delta: 0 uses the largest weight of the grid, so every edge is light.
+// threads: 0 uses one thread per online core.
+void deltaSteppingInit(u32 delta, u32 threads);
+void deltaSteppingStep(void);
+
+b8  deltaSteppingShouldStop(void);
+
+// Distance from source to every cell (GRID_INFINITY if unreachable) for
+// distance-map jobs on weighted grids. parent may be NULL. Reads the moves of
+// the grid, which gridBuildMoves() must have built.
+void deltaSteppingDistanceMap(const Grid* grid, u32 source, u32 delta, u32* distance, u32* parent, u32 threads);
+
+#endif // PF_DELTA_STEPPING_H
@@ -3,7 +3,9 @@
 
 #include "common.h"
 
-void dijkstraInit(u64 capacity);
+#include "priority_queue.h"
+
+void dijkstraInit(u64 capacity, PriorityQueueKind queue);
 void dijkstraStep(void);
 
 b8  dijkstraShouldStop(void);
@@ -2,57 +2,174 @@
 #define PF_GRID_H
 
 #include "common.h"
-#include "raylib.h"
 
-#define CELL_PATH_COLOR     RAYWHITE
-#define CELL_WALL_COLOR     GRAY
-#define CELL_START_COLOR    RED
-#define CELL_GOAL_COLOR     GREEN
-#define CELL_VISITED_COLOR  YELLOW
-#define CELL_SOLUTION_COLOR MAGENTA
+// Cells are addressed by a 32-bit index (row * cols + col), the all-ones
+// index marks "no cell"
+#define GRID_NO_CELL    UINT32_MAX
+#define GRID_MAX_CELLS  (UINT32_MAX - 1)
+#define GRID_INFINITY   UINT32_MAX
 
-typedef struct Cell
-{
-    // 8 bytes
-    u32     distance;
-    u32     weight;
+// Movement models. 4-connected moves cost the weight of the cell entered.
+// 8-connected moves cost that weight times GRID_COST_STRAIGHT or
+// GRID_COST_DIAGONAL, integers whose ratio is within 2e-6 of sqrt(2).
+#define GRID_CONNECT_4      4
+#define GRID_CONNECT_8      8
+#define GRID_COST_STRAIGHT  408
+#define GRID_COST_DIAGONAL  577
+
+// Largest weight of a cell. It keeps the largest 8-connected step
+// (GRID_MAX_WEIGHT * GRID_COST_DIAGONAL) and the bucket counts derived from
+// it well inside a u32.
+#define GRID_MAX_WEIGHT     (1u << 20)
 
-    // 8 bytes
-    u16     x_pos;
-    u16     y_pos;
-    u16     width;
-    u16     height;
+// Bits of Grid.moves, one per direction
+#define GRID_MOVE_LEFT          (1u << 0)
+#define GRID_MOVE_UP            (1u << 1)
+#define GRID_MOVE_RIGHT         (1u << 2)
+#define GRID_MOVE_DOWN          (1u << 3)
+#define GRID_MOVE_UP_LEFT       (1u << 4)
+#define GRID_MOVE_UP_RIGHT      (1u << 5)
+#define GRID_MOVE_DOWN_LEFT     (1u << 6)
+#define GRID_MOVE_DOWN_RIGHT    (1u << 7)
 
-    // 8 bytes
-    struct Cell* parent;
+// Structure-of-arrays grid: map data and search state are kept in separate
+// arrays so a search only pulls the few bytes per cell it actually reads
+typedef struct Grid
+{
+    u32     rows;
+    u32     cols;
+    u32     start;
+    u32     goal;
 
-    // 4 bytes
-    Color   color;
+    // Map data
+    u32*    weight;
+    u64*    wall;           // 1 bit per cell
+    u32     max_weight;     // largest value in weight[]
+    u64     max_count;      // cells holding max_weight, 0 when not counted yet
+    u32     revision;       // bumped whenever a wall or weight changes, for caches built from the map
+    u32     connectivity;   // GRID_CONNECT_4 (the default) or GRID_CONNECT_8, kept across maps
 
-    // 4 bytes
-    u8      is_start;
-    u8      is_goal;
-    u8      is_visited;
-    u8      is_wall;
+    // The moves that leave each cell for an open neighbor, GRID_MOVE_* bits.
+    // The grid edges act as a border of sentinel walls, so searches read one
+    // byte per cell instead of checking bounds and walls per neighbor.
+    // Built by gridBuildMoves() and kept up to date by the setters.
+    u8*     moves;
 
-    // 4 bytes
-    u32     heuristic;
+    // Search state. distance, parent and heuristic only hold values for the
+    // cells whose stamp matches epoch: gridReset() starts a new epoch instead
+    // of clearing them, and gridTouch() clears a cell the first time a search
+    // reaches it.
+    u32*    distance;
+    u32*    parent;         // GRID_NO_CELL for the start and unreached cells
+    u32*    heuristic;
+    u32*    stamp;          // epoch in which each cell was last touched
+    u32     epoch;
+    u64*    visited;        // 1 bit per cell, cleared by gridReset()
+    u64*    reached;        // 1 bit per cell touched by the search, cleared by gridReset()
 
-    // 2 bytes (+ 2 bytes)
-    u8      row;
-    u8      col;
-} Cell; // 40 bytes
+    // Set when weight and wall live in a memory-mapped map file
+    void*   mapping;
+    u64     mapping_size;
+} Grid;
 
-void gridCreate(u16 window_width, u16 window_height, u8 grid_rows, u8 grid_cols);
+void gridCreate(u32 grid_rows, u32 grid_cols);
+// Creates a grid whose weight and wall arrays point into a memory-mapped
+// file instead of being allocated. gridDestroy() unmaps it.
+void gridCreateMapped(u32 grid_rows, u32 grid_cols, u32* weight, u64* wall, u32 max_weight,
+                      void* mapping, u64 mapping_size);
 void gridDestroy(void);
 
-void gridUpdate(void);
-void gridDraw(void);
+// Clears walls, weights, start and goal
+void gridClear(void);
+// Starts a new search: distance, parent and heuristic of every cell become
+// stale in O(1), the visited and reached bitsets are still cleared in O(cells)
+void gridReset(void);
+// Builds the moves of every cell if they are missing: NULL until the first
+// search, so loading a map never pays for them
+void gridBuildMoves(void);
+// Touches every cell at once, for searches that fill the whole arrays or
+// write them from several threads
+void gridTouchAll(void);
+
+void gridSetStart(u32 row, u32 col);
+void gridSetGoal(u32 row, u32 col);
+void gridSetWall(u32 row, u32 col, b8 is_wall);
+// Clamped to 1..GRID_MAX_WEIGHT
+void gridSetWeight(u32 row, u32 col, u32 weight);
+// Takes effect with the next search
+void gridSetConnectivity(u32 connectivity);
+
+Grid*   gridGet(void);
+u32     gridGetStart(void);
+u32     gridGetGoal(void);
+u32     gridGetCell(u32 row, u32 col);
+u32     gridGetRows(void);
+u32     gridGetCols(void);
+u64     gridGetCellCount(void);
+u64     gridGetMemoryBytes(void);
+
+static inline b8
+gridBitTest(const u64* bits, u32 cell)
+{
+    return (bits[cell >> 6] >> (cell & 63)) & 1;
+}
+
+static inline void
+gridBitSet(u64* bits, u32 cell)
+{
+    bits[cell >> 6] |= 1ull << (cell & 63);
+}
 
-void*   gridGetStart(void);
-void*   gridGetGoal(void);
-void*   gridGetCell(u8 row, u8 col);
-u8      gridGetRows(void);
-u8      gridGetCols(void);
+static inline void
+gridBitClear(u64* bits, u32 cell)
+{
+    bits[cell >> 6] &= ~(1ull << (cell & 63));
+}
+
+static inline b8
+gridIsWall(const Grid* grid, u32 cell)
+{
+    return gridBitTest(grid->wall, cell);
+}
+
+// Call before the current search first reads or writes distance, parent or
+// heuristic of a cell: a cell left over from an earlier search is reset to
+// GRID_INFINITY, GRID_NO_CELL and 0
+static inline void
+gridTouch(Grid* grid, u32 cell)
+{
+    if (grid->stamp[cell] == grid->epoch) return;
+
+    grid->stamp[cell]     = grid->epoch;
+    grid->distance[cell]  = GRID_INFINITY;
+    grid->parent[cell]    = GRID_NO_CELL;
+    grid->heuristic[cell] = 0;
+    gridBitSet(grid->reached, cell);
+}
+
+// Read-only access for cells the current search may not have touched
+static inline u32
+gridGetDistance(const Grid* grid, u32 cell)
+{
+    return grid->stamp[cell] == grid->epoch ? grid->distance[cell] : GRID_INFINITY;
+}
+
+static inline u32
+gridGetParent(const Grid* grid, u32 cell)
+{
+    return grid->stamp[cell] == grid->epoch ? grid->parent[cell] : GRID_NO_CELL;
+}
+
+static inline b8
+gridIsVisited(const Grid* grid, u32 cell)
+{
+    return gridBitTest(grid->visited, cell);
+}
+
+static inline void
+gridMarkVisited(Grid* grid, u32 cell)
+{
+    gridBitSet(grid->visited, cell);
+}
 
-#endif // PF_GRID_H
\ No newline at end of file
+#endif // PF_GRID_H
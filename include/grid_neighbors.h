@@ -0,0 +1,138 @@
+#ifndef PF_GRID_NEIGHBORS_H
+#define PF_GRID_NEIGHBORS_H
+
+#include "common.h"
+
+#include "grid.h"
+
+// The kernels below take the connectivity as a parameter, but callers pass a
+// constant: each search instantiates one copy per movement model and picks
+// the copy once when it starts, so the branches on connectivity fold away and
+// the 4-connected copy compiles to the same code as a dedicated one.
+#if defined(__GNUC__) || defined(__clang__)
+    #define GRID_KERNEL static inline __attribute__((always_inline))
+#elif defined(_MSC_VER)
+    #define GRID_KERNEL static __forceinline
+#else
+    #define GRID_KERNEL static inline
+#endif
+
+// Writes the open neighbors of cell to neighbors and returns their count.
+// The order is fixed, so every search breaks ties the same way: left, up,
+// right, down, then up-left, up-right, down-left, down-right. A diagonal move
+// may not cut a corner: both cells beside it must be open. Reads only the
+// moves of cell, which gridBuildMoves() must have built.
+//
+// With GRID_CONNECT_8, steps receives the cost factor of each move for
+// gridMoveCost(). With GRID_CONNECT_4 it is left untouched.
+GRID_KERNEL u32
+gridOpenNeighbors(const Grid* grid, u32 cell, u32 connectivity, u32 neighbors[8], u32 steps[8])
+{
+    u32 cols  = grid->cols;
+    u32 moves = grid->moves[cell];
+    u32 count = 0;
+
+    if (connectivity == GRID_CONNECT_4)
+    {
+        if (moves & GRID_MOVE_LEFT)  neighbors[count++] = cell - 1;
+        if (moves & GRID_MOVE_UP)    neighbors[count++] = cell - cols;
+        if (moves & GRID_MOVE_RIGHT) neighbors[count++] = cell + 1;
+        if (moves & GRID_MOVE_DOWN)  neighbors[count++] = cell + cols;
+
+        return count;
+    }
+
+    if (moves & GRID_MOVE_LEFT)       { neighbors[count] = cell - 1;        steps[count++] = GRID_COST_STRAIGHT; }
+    if (moves & GRID_MOVE_UP)         { neighbors[count] = cell - cols;     steps[count++] = GRID_COST_STRAIGHT; }
+    if (moves & GRID_MOVE_RIGHT)      { neighbors[count] = cell + 1;        steps[count++] = GRID_COST_STRAIGHT; }
+    if (moves & GRID_MOVE_DOWN)       { neighbors[count] = cell + cols;     steps[count++] = GRID_COST_STRAIGHT; }
+    if (moves & GRID_MOVE_UP_LEFT)    { neighbors[count] = cell - cols - 1; steps[count++] = GRID_COST_DIAGONAL; }
+    if (moves & GRID_MOVE_UP_RIGHT)   { neighbors[count] = cell - cols + 1; steps[count++] = GRID_COST_DIAGONAL; }
+    if (moves & GRID_MOVE_DOWN_LEFT)  { neighbors[count] = cell + cols - 1; steps[count++] = GRID_COST_DIAGONAL; }
+    if (moves & GRID_MOVE_DOWN_RIGHT) { neighbors[count] = cell + cols + 1; steps[count++] = GRID_COST_DIAGONAL; }
+
+    return count;
+}
+
+// The cells next to cell inside the grid, walls included, in the order of
+// gridOpenNeighbors(). For passes that also cross walls, like a flood fill
+// that clears them; searches read the moves mask instead.
+static inline u32
+gridAdjacentCells(const Grid* grid, u32 cell, u32 neighbors[4])
+{
+    u32 row   = cell / grid->cols;
+    u32 col   = cell % grid->cols;
+    u32 count = 0;
+
+    if (col > 0)                neighbors[count++] = cell - 1;
+    if (row > 0)                neighbors[count++] = cell - grid->cols;
+    if (col + 1 < grid->cols)   neighbors[count++] = cell + 1;
+    if (row + 1 < grid->rows)   neighbors[count++] = cell + grid->cols;
+
+    return count;
+}
+
+// Cost of the i-th move returned by gridOpenNeighbors(): the weight of the
+// cell entered, times the step factor when moving 8-connected
+GRID_KERNEL u64
+gridMoveCost(const Grid* grid, u32 connectivity, const u32 neighbors[8], const u32 steps[8], u32 i)
+{
+    if (connectivity == GRID_CONNECT_4) return grid->weight[neighbors[i]];
+
+    return (u64)grid->weight[neighbors[i]] * steps[i];
+}
+
+// Number of 4-connected moves between two cells on an open grid, the
+// heuristic of the searches that only move 4-connected
+static inline u32
+gridManhattanDistance(const Grid* grid, u32 a, u32 b)
+{
+    u32 a_row = a / grid->cols, a_col = a % grid->cols;
+    u32 b_row = b / grid->cols, b_col = b % grid->cols;
+
+    u32 d_row = a_row > b_row ? a_row - b_row : b_row - a_row;
+    u32 d_col = a_col > b_col ? a_col - b_col : b_col - a_col;
+
+    return d_row + d_col;
+}
+
+// Lower bound of the cost between two cells, consistent since every weight
+// is at least 1: the Manhattan distance 4-connected, the octile distance
+// 8-connected
+GRID_KERNEL u32
+gridDistanceBound(const Grid* grid, u32 connectivity, u32 a, u32 b)
+{
+    if (connectivity == GRID_CONNECT_4) return gridManhattanDistance(grid, a, b);
+
+    u32 a_row = a / grid->cols, a_col = a % grid->cols;
+    u32 b_row = b / grid->cols, b_col = b % grid->cols;
+
+    u32 d_row = a_row > b_row ? a_row - b_row : b_row - a_row;
+    u32 d_col = a_col > b_col ? a_col - b_col : b_col - a_col;
+    u32 d_min = d_row < d_col ? d_row : d_col;
+    u32 d_max = d_row < d_col ? d_col : d_row;
+
+    return d_max * GRID_COST_STRAIGHT + d_min * (GRID_COST_DIAGONAL - GRID_COST_STRAIGHT);
+}
+
+// Cost of the move from one cell to an adjacent one, for walking a finished
+// path outside the hot loops
+static inline u64
+gridStepCost(const Grid* grid, u32 from, u32 to)
+{
+    if (grid->connectivity == GRID_CONNECT_4) return grid->weight[to];
+
+    b8 diagonal = from / grid->cols != to / grid->cols && from % grid->cols != to % grid->cols;
+
+    return (u64)grid->weight[to] * (diagonal == 1 ? GRID_COST_DIAGONAL : GRID_COST_STRAIGHT);
+}
+
+// Largest cost of a single move, the key step bound of the priority queues.
+// Computed in u64 so a bad max_weight can't wrap it into a small bound.
+static inline u64
+gridMaxStepCost(const Grid* grid)
+{
+    return grid->connectivity == GRID_CONNECT_4 ? grid->max_weight : (u64)grid->max_weight * GRID_COST_DIAGONAL;
+}
+
+#endif // PF_GRID_NEIGHBORS_H
@@ -0,0 +1,28 @@
+#ifndef PF_GRID_VIEW_H
+#define PF_GRID_VIEW_H
+
+#include "common.h"
+#include "raylib.h"
+
+#define CELL_PATH_COLOR     RAYWHITE
+#define CELL_WALL_COLOR     GRAY
+#define CELL_START_COLOR    RED
+#define CELL_GOAL_COLOR     GREEN
+#define CELL_VISITED_COLOR  YELLOW
+#define CELL_FRONTIER_COLOR ORANGE
+#define CELL_SOLUTION_COLOR MAGENTA
+#define CELL_WAYPOINT_COLOR BLUE
+
+// Lays the grid created with gridCreate() out inside the window and starts
+// the search worker
+void gridViewCreate(u16 window_width, u16 window_height);
+// Stops the search worker and frees the grid texture, call before the window
+// closes
+void gridViewDestroy(void);
+
+void gridUpdate(void);
+void gridDraw(void);
+// Counters and phase times of the last search, in the margin above the grid
+void gridDrawStats(void);
+
+#endif // PF_GRID_VIEW_H
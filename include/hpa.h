@@ -0,0 +1,30 @@
+#ifndef PF_HPA_H
+#define PF_HPA_H
+
+#include "common.h"
+
+#include "priority_queue.h"
+
+// Side of the square clusters the grid is split into
+#define HPA_CLUSTER_SIZE 16
+
+// Hierarchical A*: the grid is split into clusters, cells where two clusters
+// can be crossed become abstract nodes, and the costs between the nodes of a
+// cluster are precomputed. A query searches the abstract graph and then
+// refines every hop into grid cells, so paths can be slightly longer than
+// optimal.
+//
+// The abstraction is built by the first query and kept while the map stays
+// the same. hpaCellChanged() marks the clusters touched by an edit, and only
+// those are rebuilt by the next query.
+void hpaInit(u64 capacity, PriorityQueueKind queue);
+void hpaStep(void);
+
+b8  hpaShouldStop(void);
+
+void hpaCellChanged(u32 cell);
+
+// Total number of abstract nodes, 0 before the first query
+u64 hpaGetNodeCount(void);
+
+#endif // PF_HPA_H
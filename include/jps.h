@@ -0,0 +1,19 @@
+#ifndef PF_JPS_H
+#define PF_JPS_H
+
+#include "common.h"
+
+#include "priority_queue.h"
+
+// Jump Point Search for uniform-cost 4-connected grids. Weights are ignored,
+// so searchInit() only picks it when every weight is 1.
+//
+// With use_jump_table set (JPS+) the jump distances of every cell are read
+// from a table that is built once per map revision instead of scanning the
+// grid on every jump.
+void jpsInit(u64 capacity, PriorityQueueKind queue, b8 use_jump_table);
+void jpsStep(void);
+
+b8  jpsShouldStop(void);
+
+#endif // PF_JPS_H
@@ -0,0 +1,85 @@
+#ifndef PF_LANDMARKS_H
+#define PF_LANDMARKS_H
+
+#include "common.h"
+
+#include "grid.h"
+#include "grid_neighbors.h"
+
+#define LANDMARKS_DEFAULT_COUNT 8
+#define LANDMARKS_MAX_COUNT     64
+
+// Landmark tables of A* with ALT (A*, Landmarks, Triangle inequality). The
+// exact cost from every landmark to every cell and back bounds the cost
+// between any two cells from below: d(n, g) >= d(L, g) - d(L, n) and
+// d(n, g) >= d(n, L) - d(g, L). Unlike the Manhattan or octile distance the
+// bound sees walls and weights, so on mazes and weighted maps A* expands far
+// fewer cells.
+//
+// Both directions are kept because costs are not symmetric: a move costs the
+// weight of the cell it enters. The entries of one cell are next to each
+// other, so a bound reads one or two cache lines per table.
+typedef struct LandmarkTables
+{
+    u32     count;          // landmarks actually placed, at most the requested count
+    u32     requested;
+    u32*    cells;
+
+    u32*    from;           // from[cell * count + i]: cost from landmark i to cell
+    u32*    to;             // to[cell * count + i]:   cost from cell to landmark i
+
+    // The map the tables were built for
+    u64     cell_count;
+    u32     connectivity;
+    u32     revision;
+} LandmarkTables;
+
+// Landmarks placed by the next build, LANDMARKS_DEFAULT_COUNT by default
+void landmarksSetCount(u32 count);
+u32  landmarksGetCount(void);
+
+// The tables of the current grid, built first unless they are up to date.
+// Landmarks are spread by farthest-point selection over move counts, starting
+// from the start cell (or the first open cell), so they cover its connected
+// region. The 2 * count full Dijkstra searches then run on searchGetThreads()
+// threads.
+const LandmarkTables* landmarksPrepare(void);
+void                  landmarksDestroy(void);
+
+// Binary tables (.pflm): a header with the size, connectivity and a hash of
+// the walls and weights, the landmark cells and both tables. Loading fails
+// when the file was built for another map or landmark count.
+b8   landmarksSave(const char* path);
+b8   landmarksLoad(const char* path);
+
+// Memory of the tables, 0 before the first build
+u64  landmarksGetMemoryBytes(void);
+
+// Lower bound of the cost from cell to goal. Landmarks that can't reach both
+// cells are skipped: the cells are then in different regions, and the search
+// fails whatever the bound.
+GRID_KERNEL u32
+landmarksBound(const LandmarkTables* tables, u32 cell, u32 goal)
+{
+    u32 count = tables->count;
+    if (count == 0) return 0;
+
+    const u32* from_cell = tables->from + (u64)cell * count;
+    const u32* from_goal = tables->from + (u64)goal * count;
+    const u32* to_cell   = tables->to   + (u64)cell * count;
+    const u32* to_goal   = tables->to   + (u64)goal * count;
+
+    u32 bound = 0;
+    for (u32 i = 0; i < count; ++i)
+    {
+        // Moves are symmetric, so a landmark reaching a cell is reached from it too
+        if (from_cell[i] == GRID_INFINITY || from_goal[i] == GRID_INFINITY) continue;
+
+        if (from_goal[i] > from_cell[i] && from_goal[i] - from_cell[i] > bound) bound = from_goal[i] - from_cell[i];
+        if (to_cell[i]   > to_goal[i]   && to_cell[i]   - to_goal[i]   > bound) bound = to_cell[i]   - to_goal[i];
+    }
+
+    return bound;
+}
+
+#endif // PF_LANDMARKS_H
@@ -0,0 +1,18 @@
+#ifndef PF_LPA_STAR_H
+#define PF_LPA_STAR_H
+
+#include "common.h"
+
+// Lifelong Planning A*: keeps g (grid->distance) and rhs values between map
+// edits, so after a change only the cells whose distance it affects are
+// processed again.
+void lpaStarInit(u64 capacity);
+void lpaStarStep(void);
+
+b8  lpaStarShouldStop(void);
+
+// Call after the wall or weight of cell changed. Moving the start or the goal
+// restarts the planner. The search resumes on the next lpaStarStep().
+void lpaStarCellChanged(u32 cell);
+
+#endif // PF_LPA_STAR_H
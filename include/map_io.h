@@ -0,0 +1,56 @@
+#ifndef PF_MAP_IO_H
+#define PF_MAP_IO_H
+
+#include "common.h"
+
+// The loaders replace the current grid only once the file is known to be
+// valid, a file that fails to load leaves the grid as it was.
+
+// Loads an ASCII map into the grid, one line per row:
+//   '.' open cell, '#' or '@' wall, 'S' start, 'G' goal, '1'..'9' weighted cell
+b8 mapLoad(const char* path);
+// Writes the grid in the same format, weights above 9 are written as 9
+b8 mapSave(const char* path);
+
+// MovingAI benchmark maps (.map): an "octile" header followed by the rows.
+// '.', 'G' and 'S' are open, every other terrain is loaded as a wall. The
+// format has no start, goal or weights, saving writes walls as '@'.
+b8 mapLoadMovingAi(const char* path);
+b8 mapSaveMovingAi(const char* path);
+
+// Binary maps (.pfmap): a small header, the wall bitset and the weights as
+// they are laid out in the grid. Loading maps the file into the grid instead
+// of reading it, edits stay private to the process. Files holding a weight
+// outside 1..GRID_MAX_WEIGHT are refused.
+b8 mapLoadBinary(const char* path);
+b8 mapSaveBinary(const char* path);
+
+// Picks the format from the extension: .map, .pfmap, ASCII otherwise
+b8 mapLoadAny(const char* path);
+b8 mapSaveAny(const char* path);
+
+// One query of a MovingAI scenario (.scen), x is the column and y the row
+typedef struct ScenarioEntry
+{
+    u32     bucket;
+    u32     map_width;
+    u32     map_height;
+    u32     start_x;
+    u32     start_y;
+    u32     goal_x;
+    u32     goal_y;
+    double  optimal_length;     // octile distance with diagonal moves
+} ScenarioEntry;
+
+typedef struct Scenario
+{
+    char            map_name[256];  // map of the first entry, relative to the scenario
+    ScenarioEntry*  entries;
+    u64             count;
+} Scenario;
+
+b8   scenarioLoad(const char* path, Scenario* scenario);
+b8   scenarioSave(const char* path, const Scenario* scenario);
+void scenarioDestroy(Scenario* scenario);
+
+#endif // PF_MAP_IO_H
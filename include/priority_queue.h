@@ -0,0 +1,67 @@
+#ifndef PF_PRIORITY_QUEUE_H
+#define PF_PRIORITY_QUEUE_H
+
+#include "common.h"
+#include "ds/heap.h"
+
+typedef enum {
+    PQ_BINARY_HEAP  = 0,    // WIM binary heap, lazy deletion
+    PQ_BUCKET       = 1,    // Dial's buckets, monotone integer keys, lazy deletion
+    PQ_RADIX        = 2,    // radix heap, monotone integer keys, lazy deletion
+    PQ_DARY         = 3,    // indexed 4-ary heap with decrease-key
+    PQ_COUNT
+} PriorityQueueKind;
+
+// The key is stored next to the cell index, so comparisons never read the
+// grid and a later relaxation can't reorder entries already in the queue
+typedef struct PQEntry
+{
+    u32     priority;
+    u32     cell;
+} PQEntry;
+
+typedef struct PQBucket
+{
+    PQEntry*        entries;
+    u32             size;
+    u32             capacity;
+} PQBucket;
+
+typedef struct PriorityQueue
+{
+    PriorityQueueKind   kind;
+    u64                 size;
+
+    // PQ_BINARY_HEAP
+    Heap                heap;
+
+    // PQ_BUCKET: a ring of max_key_step + 1 buckets, one per key, starting at `cursor`
+    // PQ_RADIX:  33 buckets, by the highest bit in which a key differs from `cursor`
+    PQBucket*           buckets;
+    u32                 bucket_count;
+    u32                 cursor;         // smallest key that can still be popped
+
+    // PQ_DARY
+    PQEntry*            nodes;
+    u32*                position;       // slot of every cell in `nodes`, GRID_NO_CELL when absent
+} PriorityQueue;
+
+// capacity:     number of cells of the grid
+// max_key_step: largest amount a pushed key can exceed the last popped key,
+//               only used by PQ_BUCKET
+PriorityQueue pqCreate(PriorityQueueKind kind, u64 capacity, u32 max_key_step);
+void          pqDestroy(PriorityQueue* queue);
+
+// Empties the queue but keeps its memory, so one queue can serve many searches
+void          pqClear(PriorityQueue* queue);
+
+// Inserts the cell, or lowers its key if the queue supports decrease-key and
+// already holds it. Lazy queues keep the old entry, which later pops as stale.
+void    pqPush(PriorityQueue* queue, u32 cell, u32 priority);
+void    pqPop(PriorityQueue* queue, PQEntry* entry);
+b8      pqIsEmpty(const PriorityQueue* queue);
+
+const char*         pqKindName(PriorityQueueKind kind);
+PriorityQueueKind   pqKindFromName(const char* name);   // PQ_COUNT when unknown
+
+#endif // PF_PRIORITY_QUEUE_H
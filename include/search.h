@@ -0,0 +1,156 @@
+#ifndef PF_SEARCH_H
+#define PF_SEARCH_H
+
+#include "common.h"
+
+#include "priority_queue.h"
+#include "search_path.h"
+
+// Lets searchInit() pick the priority queue from the grid weights
+#define SEARCH_QUEUE_AUTO PQ_COUNT
+
+typedef enum {
+    ALGO_NONE           = 0,
+    ALGO_BFS            = 1,
+    ALGO_DFS            = 2,
+    ALGO_DIJKSTRA       = 3,
+    ALGO_ASTAR          = 4,
+    ALGO_JPS            = 5,
+    ALGO_JPS_PLUS       = 6,
+    ALGO_BFS_BIDIR      = 7,
+    ALGO_DIJKSTRA_BIDIR = 8,
+    ALGO_ASTAR_BIDIR    = 9,
+    ALGO_LPA_STAR       = 10,
+    ALGO_HPA            = 11,
+    ALGO_BFS_PARALLEL   = 12,
+    ALGO_DELTA_STEPPING = 13,
+    ALGO_ASTAR_ALT      = 14,
+    ALGO_COUNT
+} SearchAlgo;
+
+typedef struct SearchStats
+{
+    u64     expanded;       // cells taken off the frontier and expanded
+    u64     pushes;         // entries added to the frontier, decrease-key updates included
+    u64     frontier;       // entries currently in the frontier
+    u64     peak_frontier;  // largest frontier seen during the search
+    u64     stale_pops;     // outdated duplicates popped from a lazy-deletion queue
+} SearchStats;
+
+typedef struct SearchResult
+{
+    b8          found;
+    u32         path_length;    // cells on the path, start and goal included
+    u64         path_cost;      // sum of the weights entered after the start
+    u64         elapsed_ns;     // init_ns + search_ns
+
+    // Wall-clock time per phase. Init includes building the JPS+ table, the
+    // HPA* abstraction and the landmark tables when the map changed.
+    u64         init_ns;
+    u64         search_ns;
+    u64         path_ns;        // walking the parents from the goal to measure the path
+
+    SearchStats stats;
+} SearchResult;
+
+// Step-wise interface used by the visualizer. The searches keep their state
+// in cells stamped with the grid's epoch, so call gridReset() before
+// searchInit(), as searchRun() and the search worker do.
+void    searchInit(SearchAlgo algo);
+void    searchStep(void);
+b8      searchShouldStop(void);
+b8      searchHasFoundPath(void);
+
+// Steps until the search stops or budget_ns has passed, the clock is read
+// every few steps. A budget of 0 takes a single step, SEARCH_BUDGET_UNLIMITED
+// runs the search to completion. Returns the number of steps taken.
+#define SEARCH_BUDGET_UNLIMITED UINT64_MAX
+u64     searchStepFor(u64 budget_ns);
+
+// Time spent in searchInit() and searchStepFor() since the last searchInit()
+u64     searchGetElapsedNs(void);
+
+// Tells the running search that the wall, weight, start or goal of cell
+// changed. Returns 1 when the search replans incrementally (LPA*): it then
+// resumes on the next step, with its stats and timer counting only the repair.
+// Other searches ignore the change and return 0. The HPA* abstraction is
+// kept up to date whichever search is active.
+b8      searchNotifyCellChanged(u32 cell);
+
+// Resets the grid and runs the search to completion
+SearchResult searchRun(SearchAlgo algo);
+
+// Result of the last step-wise search so far, found is 0 until it stops at
+// the goal
+SearchResult searchGetResult(void);
+
+// Writes the path of the last step-wise search to path, start first, in one
+// walk of the parents. Returns 0 and leaves path empty unless the search
+// stopped at the goal.
+b8           searchGetPath(SearchPath* path);
+
+// Writes result as a single-line JSON object, truncated to size bytes with
+// the terminator. Returns the length of the whole object like snprintf(), so
+// a return of size or more means the buffer was too small.
+u64 searchResultToJson(SearchAlgo algo, const SearchResult* result, char* buffer, u64 size);
+
+// Priority queue used by Dijkstra and A*, SEARCH_QUEUE_AUTO by default
+void                searchSetQueue(PriorityQueueKind queue);
+PriorityQueueKind   searchGetQueue(void);
+
+// Threads of the parallel BFS and delta-stepping, 0 (the default) uses one per core
+void                searchSetThreads(u32 threads);
+u32                 searchGetThreads(void);
+
+// Bucket width of delta-stepping, 0 (the default) uses the largest grid weight
+void                searchSetDelta(u32 delta);
+u32                 searchGetDelta(void);
+
+// The queue a search uses for the given setting: SEARCH_QUEUE_AUTO picks Dial's
+// buckets while the step costs are small enough, a radix heap otherwise. An
+// explicit PQ_BUCKET also falls back to the radix heap once the step costs
+// need an unreasonably large ring.
+PriorityQueueKind   searchResolveQueue(PriorityQueueKind queue, u64 max_step_cost);
+
+// The algorithm searchInit() actually runs on the current grid. BFS, DFS,
+// Dijkstra and A* support 8-connected movement, the others are replaced by the
+// closest of them. JPS runs A* on weighted grids.
+SearchAlgo          searchResolveAlgo(SearchAlgo algo);
+
+// Counters of the running search, cleared by searchInit()
+SearchStats* searchGetStats(void);
+
+static inline void
+searchStatsPush(SearchStats* stats)
+{
+    stats->pushes   += 1;
+    stats->frontier += 1;
+    if (stats->frontier > stats->peak_frontier) stats->peak_frontier = stats->frontier;
+}
+
+static inline void
+searchStatsPop(SearchStats* stats)
+{
+    stats->frontier -= 1;
+}
+
+// For queues whose size doesn't grow on every push (decrease-key)
+static inline void
+searchStatsSetFrontier(SearchStats* stats, u64 frontier)
+{
+    stats->frontier = frontier;
+    if (stats->frontier > stats->peak_frontier) stats->peak_frontier = stats->frontier;
+}
+
+// One push to a queue that holds frontier entries afterwards
+static inline void
+searchStatsQueuePush(SearchStats* stats, u64 frontier)
+{
+    stats->pushes += 1;
+    searchStatsSetFrontier(stats, frontier);
+}
+
+const char* searchAlgoName(SearchAlgo algo);
+SearchAlgo  searchAlgoFromName(const char* name);
+
+#endif // PF_SEARCH_H
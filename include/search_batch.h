@@ -0,0 +1,30 @@
+#ifndef PF_SEARCH_BATCH_H
+#define PF_SEARCH_BATCH_H
+
+#include "common.h"
+
+#include "search.h"
+#include "priority_queue.h"
+
+typedef struct SearchQuery
+{
+    u32     start;
+    u32     goal;
+} SearchQuery;
+
+// Runs count queries over the grid on a pool of worker threads and
+// writes the result of queries[i] to results[i]. Each worker owns a
+// SearchContext and starts with an equal slice of the queries; a worker that
+// runs out steals the back half of another worker's remaining slice, so
+// uneven query costs still keep every core busy.
+//
+// Always searches the grid gridGet() returns and builds its moves first.
+// threads: 0 uses one worker per online core. The grid must not change until
+// the call returns. Only algorithms searchContextSupports() accepts.
+void searchBatchRun(SearchAlgo algo, PriorityQueueKind queue,
+                    const SearchQuery* queries, u64 count, SearchResult* results, u32 threads);
+
+// Number of online cores, at least 1
+u32  searchBatchDefaultThreads(void);
+
+#endif // PF_SEARCH_BATCH_H
@@ -0,0 +1,50 @@
+#ifndef PF_SEARCH_CONTEXT_H
+#define PF_SEARCH_CONTEXT_H
+
+#include "common.h"
+
+#include "grid.h"
+#include "search.h"
+#include "priority_queue.h"
+
+// Search state of one query over a grid that is only read. Unlike the
+// step-wise searches, which keep their state in globals and in the grid's own
+// arrays, any number of contexts can search the same grid at once, one per
+// thread. Supports BFS, Dijkstra and A*.
+typedef struct SearchContext
+{
+    const Grid*     grid;
+    u64             cell_count;
+
+    // Valid until the next searchContextRun()
+    u32*            distance;
+    u32*            parent;         // GRID_NO_CELL for the start and unreached cells
+    u64*            visited;        // 1 bit per cell
+    SearchStats     stats;
+
+    // Cells whose state the last query changed, so the next one only resets
+    // those. BFS also uses it as its FIFO: cells are queued in the order they
+    // are reached.
+    u32*            touched;
+    u64             touched_count;
+
+    PriorityQueue   queue;
+} SearchContext;
+
+// queue may be SEARCH_QUEUE_AUTO. The grid must outlive the context and keep
+// its size and weights while the context is in use, and its moves must be
+// built (gridBuildMoves()), since contexts only read the grid.
+SearchContext searchContextCreate(const Grid* grid, PriorityQueueKind queue);
+void          searchContextDestroy(SearchContext* context);
+
+// Runs algo from start to goal to completion. Unsupported algorithms return
+// a result with found set to 0.
+SearchResult  searchContextRun(SearchContext* context, SearchAlgo algo, u32 start, u32 goal);
+
+b8            searchContextSupports(SearchAlgo algo);
+
+// Writes the path to goal of the last searchContextRun(), which must have
+// found it, to path, start first
+void          searchContextGetPath(const SearchContext* context, u32 goal, SearchPath* path);
+
+#endif // PF_SEARCH_CONTEXT_H
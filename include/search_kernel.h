@@ -0,0 +1,175 @@
+#ifndef PF_SEARCH_KERNEL_H
+#define PF_SEARCH_KERNEL_H
+
+#include "common.h"
+
+#include "grid.h"
+#include "grid_neighbors.h"
+#include "landmarks.h"
+#include "priority_queue.h"
+#include "search.h"
+#include "trace.h"
+
+// Frontier policies of the kernel
+#define SEARCH_FRONTIER_FIFO        0   // BFS: cells are visited when reached, in the order they were reached
+#define SEARCH_FRONTIER_LIFO        1   // DFS: the same, newest first
+#define SEARCH_FRONTIER_PRIORITY    2   // Dijkstra and A*: cells are visited when popped with the lowest key
+
+// Lower bounds added to the key of the PRIORITY frontier
+#define SEARCH_HEURISTIC_NONE       0   // Dijkstra
+#define SEARCH_HEURISTIC_DISTANCE   1   // A*: Manhattan or octile distance
+#define SEARCH_HEURISTIC_LANDMARKS  2   // A* with ALT: the larger of the distance and the landmark bound
+
+// Step-wise search shared by BFS, DFS, Dijkstra and A*. Each of them
+// instantiates searchKernelStep() with constant policies, once per movement
+// model, so every copy compiles to a loop without branches on the policy.
+typedef struct SearchKernel
+{
+    Grid*           grid;
+    SearchStats*    stats;
+
+    // FIFO and LIFO: a cell is pushed at most once, so one slot per cell
+    // holds the whole frontier without wrapping or growing
+    u32*            cells;
+    u64             head;           // FIFO: next cell to pop
+    u64             tail;           // one past the last pushed cell
+
+    // PRIORITY: keyed by distance, plus the bound to the goal for A*
+    PriorityQueue   queue;
+    const LandmarkTables* landmarks;    // SEARCH_HEURISTIC_LANDMARKS only
+
+    u32             frontier;
+    b8              is_running;
+    b8              has_finished;
+} SearchKernel;
+
+// Starts a search from the grid's start cell. queue is only used by the
+// PRIORITY frontier.
+void searchKernelInit(SearchKernel* kernel, u32 frontier, u32 heuristic, u64 capacity, PriorityQueueKind queue);
+// Stops the search and frees its frontier
+void searchKernelFinish(SearchKernel* kernel, b8 found);
+b8   searchKernelShouldStop(const SearchKernel* kernel);
+
+// Lower bound of the cost from cell to the goal. Both bounds are consistent,
+// and so is their maximum, so a cell is never expanded twice.
+GRID_KERNEL u32
+searchKernelBound(const SearchKernel* kernel, u32 heuristic, u32 connectivity, u32 cell)
+{
+    u32 bound = gridDistanceBound(kernel->grid, connectivity, cell, kernel->grid->goal);
+
+    if (heuristic == SEARCH_HEURISTIC_LANDMARKS)
+    {
+        u32 landmark_bound = landmarksBound(kernel->landmarks, cell, kernel->grid->goal);
+        if (landmark_bound > bound) bound = landmark_bound;
+    }
+
+    return bound;
+}
+
+GRID_KERNEL void
+searchKernelStep(SearchKernel* kernel, u32 frontier, u32 heuristic, u32 connectivity)
+{
+    if (kernel->is_running == 0 || kernel->has_finished == 1) return;
+
+    Grid*        grid  = kernel->grid;
+    SearchStats* stats = kernel->stats;
+    u32          cell;
+
+    if (frontier == SEARCH_FRONTIER_PRIORITY)
+    {
+        if (pqIsEmpty(&kernel->queue) == 1)
+        {
+            searchKernelFinish(kernel, 0);
+            return;
+        }
+
+        // Choose the cell with the lowest key (the start is selected first)
+        PQEntry entry;
+        pqPop(&kernel->queue, &entry);
+        searchStatsPop(stats);
+        TRACE_EVENT(TRACE_POP, entry.cell, entry.priority);
+
+        cell = entry.cell;
+        if (gridIsVisited(grid, cell) == 1)
+        {
+            stats->stale_pops += 1;
+            return;
+        }
+        gridMarkVisited(grid, cell);
+        stats->expanded += 1;
+
+        if (cell == grid->goal)
+        {
+            TRACE_EVENT(TRACE_GOAL, cell, grid->distance[cell]);
+            searchKernelFinish(kernel, 1);
+            return;
+        }
+    }
+    else
+    {
+        if (kernel->head == kernel->tail)
+        {
+            searchKernelFinish(kernel, 0);
+            return;
+        }
+
+        cell = frontier == SEARCH_FRONTIER_FIFO ? kernel->cells[kernel->head++] : kernel->cells[--kernel->tail];
+        searchStatsPop(stats);
+        TRACE_EVENT(TRACE_POP, cell, 0);
+        stats->expanded += 1;
+    }
+
+    u32 neighbors[8];
+    u32 steps[8];
+    u32 count = gridOpenNeighbors(grid, cell, connectivity, neighbors, steps);
+
+    // For every non-visited child of the current cell
+    for (u32 i = 0; i < count; ++i)
+    {
+        u32 neighbor = neighbors[i];
+        if (gridIsVisited(grid, neighbor) == 1) continue;
+
+        gridTouch(grid, neighbor);
+
+        if (frontier != SEARCH_FRONTIER_PRIORITY)
+        {
+            gridMarkVisited(grid, neighbor);
+            grid->parent[neighbor] = cell;
+            TRACE_EVENT(TRACE_RELAX, neighbor, 0);
+
+            // BFS and DFS stop as soon as they reach the goal
+            if (neighbor == grid->goal)
+            {
+                TRACE_EVENT(TRACE_GOAL, neighbor, 0);
+                searchKernelFinish(kernel, 1);
+                return;
+            }
+
+            kernel->cells[kernel->tail++] = neighbor;
+            searchStatsPush(stats);
+            TRACE_EVENT(TRACE_PUSH, neighbor, 0);
+            continue;
+        }
+
+        // Heuristics are filled in as cells are reached, not for the whole grid up front
+        if (heuristic != SEARCH_HEURISTIC_NONE && grid->distance[neighbor] == GRID_INFINITY)
+        {
+            grid->heuristic[neighbor] = searchKernelBound(kernel, heuristic, connectivity, neighbor);
+        }
+
+        u64 temp = (u64)grid->distance[cell] + gridMoveCost(grid, connectivity, neighbors, steps, i);
+        if (temp < grid->distance[neighbor])
+        {
+            grid->distance[neighbor] = temp;
+            grid->parent[neighbor]   = cell;
+            TRACE_EVENT(TRACE_RELAX, neighbor, (u32)temp);
+
+            u32 key = heuristic != SEARCH_HEURISTIC_NONE ? temp + grid->heuristic[neighbor] : temp;
+            pqPush(&kernel->queue, neighbor, key);
+            searchStatsQueuePush(stats, kernel->queue.size);
+            TRACE_EVENT(TRACE_PUSH, neighbor, key);
+        }
+    }
+}
+
+#endif // PF_SEARCH_KERNEL_H
@@ -0,0 +1,42 @@
+#ifndef PF_SEARCH_PATH_H
+#define PF_SEARCH_PATH_H
+
+#include "common.h"
+
+#include "grid.h"
+
+// A path as one array of cells, the start first and the goal last. The
+// buffer only grows and is kept by searchPathClear(), so extracting paths
+// into the same SearchPath again stops allocating once it is large enough.
+typedef struct SearchPath
+{
+    u32*    cells;
+    u32     count;
+    u32     capacity;
+} SearchPath;
+
+void searchPathPush(SearchPath* path, u32 cell);
+void searchPathClear(SearchPath* path);
+void searchPathFree(SearchPath* path);
+
+// Fills path with the cells from the root of the parent chain to goal.
+// Walks at most cell_count parents, so a broken chain can't loop forever.
+void searchPathFromParents(SearchPath* path, const u32* parent, u32 goal, u64 cell_count);
+
+// 1 when the straight segment between the centers of a and b only crosses
+// open cells. Where the segment passes exactly through the corner of four
+// cells, both cells beside it must be open, the same rule diagonal moves
+// follow.
+b8   searchPathHasLineOfSight(const Grid* grid, u32 a, u32 b);
+
+// String pulling: keeps the start, the goal and the cells where the path has
+// to turn, dropping every cell the previous waypoint can see past. The
+// waypoints are meant to be followed in straight lines by an any-angle
+// mover. Only walls block a line, weights are not looked at, so on weighted
+// maps a line may cross cells the path went around.
+void searchPathSmooth(const Grid* grid, const SearchPath* path, SearchPath* waypoints);
+
+// Euclidean length of the lines between consecutive cells, in cells
+double searchPathLength(const Grid* grid, const SearchPath* path);
+
+#endif // PF_SEARCH_PATH_H
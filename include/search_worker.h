@@ -0,0 +1,110 @@
+#ifndef PF_SEARCH_WORKER_H
+#define PF_SEARCH_WORKER_H
+
+#include "common.h"
+
+#include "search.h"
+
+// Events in the ring, 8 bytes each
+#define SEARCH_EVENT_RING_CAPACITY (1u << 20)
+
+// What the worker tells the renderer, in the order it happens
+typedef enum {
+    SEARCH_EVENT_RESET      = 0,    // a new search started: forget every cell sent so far
+    SEARCH_EVENT_FRONTIER   = 1,    // cell reached, not expanded yet
+    SEARCH_EVENT_VISIT      = 2,    // cell expanded (BFS and DFS: reached)
+    SEARCH_EVENT_CLEAR      = 3,    // cell neither, after LPA* replanned
+    SEARCH_EVENT_PATH       = 4,    // cell of the path, the start first and the goal last
+    SEARCH_EVENT_DONE       = 5,    // the search stopped: cell is the goal, GRID_NO_CELL without a path
+    SEARCH_EVENT_CANCELLED  = 6,    // searchWorkerCancel() stopped the search
+    SEARCH_EVENT_KIND_COUNT
+} SearchEventKind;
+
+typedef struct SearchEvent
+{
+    u32     kind;
+    u32     cell;
+} SearchEvent;
+
+// Lock-free ring with a single producer and a single consumer. Each side
+// owns one index and only reads the other's, on separate cache lines so the
+// two threads don't invalidate each other's line on every event.
+typedef struct SearchEventRing
+{
+    SearchEvent*        events;
+    u64                 mask;       // capacity - 1, the capacity is a power of two
+
+    _Alignas(64) u64    tail;       // next slot the producer writes
+    _Alignas(64) u64    head;       // next slot the consumer reads
+} SearchEventRing;
+
+// Producer side. Returns 0 when the ring is full.
+static inline b8
+searchEventRingPush(SearchEventRing* ring, SearchEvent event)
+{
+    u64 tail = ring->tail;
+    if (tail - __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) > ring->mask) return 0;
+
+    ring->events[tail & ring->mask] = event;
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+
+    return 1;
+}
+
+// Consumer side. Returns 0 when the ring is empty.
+static inline b8
+searchEventRingPop(SearchEventRing* ring, SearchEvent* event)
+{
+    u64 head = ring->head;
+    if (head == __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE)) return 0;
+
+    *event = ring->events[head & ring->mask];
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+
+    return 1;
+}
+
+// Runs the step-wise search of the current grid on a background thread, so
+// a search of any length never holds up the thread that draws it. The worker
+// owns the search state of the grid (distance, parent, visited, ...) and the
+// search's globals while a search is in flight. It publishes the cells whose
+// state changed through the ring after every slice of steps, and a snapshot
+// of the result. The other thread only reads the map data and the events.
+//
+// The map (walls, weights, start, goal, connectivity) may only change between
+// searchWorkerPause() and searchWorkerResume().
+void searchWorkerCreate(void);
+// Cancels the search and joins the thread
+void searchWorkerDestroy(void);
+
+// Cancels the running search, if any, and starts algo on the worker: the
+// grid is reset and searchInit() runs there, landmark tables included.
+void searchWorkerStart(SearchAlgo algo);
+// Stops the running search after its current slice of steps. What it found
+// so far stays published, followed by SEARCH_EVENT_CANCELLED.
+void searchWorkerCancel(void);
+
+// Steps the worker takes per searchWorkerGrant(): 0 a single step,
+// budget_ns of search time otherwise. SEARCH_BUDGET_UNLIMITED runs the
+// search freely, without waiting for grants.
+void searchWorkerSetBudget(u64 budget_ns);
+// Lets the worker run one more budget, called once per frame. Grants don't
+// add up: a worker still busy with the last one takes a single next one.
+void searchWorkerGrant(void);
+
+// Blocks until the worker is between two slices and keeps it there, so the
+// map can be edited. The search resumes where it stopped. replans: one of the
+// edits made searchNotifyCellChanged() return 1, so LPA* steps again even if
+// it had already stopped.
+void searchWorkerPause(void);
+void searchWorkerResume(b8 replans);
+
+// 1 from searchWorkerStart() until the last event of the search was published
+b8   searchWorkerIsRunning(void);
+// Result of the running or last search, as of its last slice
+SearchResult searchWorkerGetResult(void);
+
+// Takes the oldest unread event. Returns 0 when there is none.
+b8   searchWorkerPollEvent(SearchEvent* event);
+
+#endif // PF_SEARCH_WORKER_H
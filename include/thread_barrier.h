@@ -0,0 +1,25 @@
+#ifndef PF_THREAD_BARRIER_H
+#define PF_THREAD_BARRIER_H
+
+#include "common.h"
+
+#include <pthread.h>
+
+// Reusable barrier for the parallel searches, pthread_barrier_t isn't
+// available everywhere
+typedef struct ThreadBarrier
+{
+    pthread_mutex_t     lock;
+    pthread_cond_t      cond;
+    u32                 count;
+    u32                 waiting;
+    u64                 generation;
+} ThreadBarrier;
+
+void barrierInit(ThreadBarrier* barrier, u32 count);
+void barrierDestroy(ThreadBarrier* barrier);
+
+// Blocks until count threads are waiting, then releases them all
+void barrierWait(ThreadBarrier* barrier);
+
+#endif // PF_THREAD_BARRIER_H
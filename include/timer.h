@@ -0,0 +1,9 @@
+#ifndef PF_TIMER_H
+#define PF_TIMER_H
+
+#include "common.h"
+
+// Monotonic clock in nanoseconds
+u64 timerNowNs(void);
+
+#endif // PF_TIMER_H
@@ -0,0 +1,94 @@
+#ifndef PF_TRACE_H
+#define PF_TRACE_H
+
+#include "common.h"
+
+// Binary trace of the step-wise BFS, DFS, Dijkstra and A* searches. Events
+// go to a preallocated ring buffer that keeps the most recent ones, so a
+// search of any size can be traced without allocating or formatting text in
+// the loop. Recording is compiled in with PF_TRACE (the PATHFINDER_TRACE
+// CMake option); without it TRACE_EVENT() expands to nothing.
+//
+// The parent of a relaxed cell is the cell of the last pop, which keeps an
+// event at 12 bytes and is enough for pathfinder_replay to rebuild the
+// parents, distances and expansion order of the search.
+#ifdef PF_TRACE
+#define TRACE_ENABLED 1
+#define TRACE_EVENT(kind, cell, value) traceRecord((kind), (cell), (value))
+#else
+#define TRACE_ENABLED 0
+#define TRACE_EVENT(kind, cell, value) ((void)0)
+#endif
+
+// Events kept by the ring buffer unless traceSetCapacity() says otherwise
+#define TRACE_DEFAULT_CAPACITY (1u << 20)
+
+typedef enum {
+    TRACE_PUSH  = 0,    // value: key of the entry, 0 for BFS and DFS
+    TRACE_POP   = 1,    // value: key of the entry, 0 for BFS and DFS
+    TRACE_RELAX = 2,    // value: new distance of the cell, 0 for BFS and DFS
+    TRACE_GOAL  = 3,    // value: distance of the goal, 0 for BFS and DFS
+    TRACE_KIND_COUNT
+} TraceEventKind;
+
+typedef struct TraceEvent
+{
+    u32     kind;
+    u32     cell;
+    u32     value;
+} TraceEvent;
+
+// Written to the search loop directly, so a record is a store and an add
+typedef struct TraceBuffer
+{
+    TraceEvent* events;
+    u64         mask;           // capacity - 1, the capacity is a power of two
+    u64         recorded;       // events since traceBegin(), dropped ones included
+} TraceBuffer;
+
+// The search a trace belongs to, and its events oldest first
+typedef struct Trace
+{
+    u32         algo;
+    u32         rows;
+    u32         cols;
+    u32         connectivity;
+    u32         start;
+    u32         goal;
+    u32         queue;          // the searchGetQueue() setting
+    u32         landmark_count; // the landmarksGetCount() setting
+    u64         recorded;
+    u64         count;          // events kept, recorded - count were dropped
+    TraceEvent* events;
+} Trace;
+
+extern TraceBuffer g_trace_buffer;
+
+static inline void
+traceRecord(u32 kind, u32 cell, u32 value)
+{
+    g_trace_buffer.events[g_trace_buffer.recorded & g_trace_buffer.mask] = (TraceEvent){ kind, cell, value };
+    g_trace_buffer.recorded += 1;
+}
+
+// Events kept by the next traceBegin(), rounded up to a power of two
+void traceSetCapacity(u64 capacity);
+u64  traceGetCapacity(void);
+
+// Clears the buffer for a search of algo on the current grid, allocating it
+// on first use. Called by searchInit() when recording is compiled in.
+void traceBegin(u32 algo);
+void traceDestroy(void);
+
+// Events recorded since traceBegin(), dropped ones included
+u64  traceGetRecorded(void);
+
+// Binary trace (.pftrace): a header with the algorithm and the settings and
+// grid it ran on, then the kept events oldest first
+b8   traceSave(const char* path);
+b8   traceLoad(const char* path, Trace* trace);
+void traceFree(Trace* trace);
+
+const char* traceKindName(u32 kind);
+
+#endif // PF_TRACE_H
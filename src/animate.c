@@ -1,26 +1,31 @@
 #include "animate.h"
 
 #include "logger.h"
-#include "ds/linked_list.h"
 
 #include "grid.h"
 
-static SLinkedList  g_path              = {0};
+#include <stdlib.h>
+
+// Cells of the solution in the order they are drawn, the start first
+static SearchPath   g_path              = {0};
+static u32          g_path_drawn        = 0;    // cells of g_path shown so far
 static b8           g_should_animate    = 0;
 
+// Cells already drawn as part of the solution, 1 bit per cell
+static u64*         g_path_cells        = NULL;
+
 void
-buildAnimationPath(void* cell)
+animateAddCell(u32 cell)
 {
-    g_path = sllCreate();
+    if (g_path_cells == NULL) g_path_cells = calloc((gridGetCellCount() + 63) / 64, sizeof(u64));
 
-    Cell* cell_ptr = (Cell*)cell;
-    while (cell_ptr != NULL)
-    {
-        sllInsertTail(&g_path, &cell_ptr, sizeof(Cell*));
-        cell_ptr = cell_ptr->parent;
-    }
+    searchPathPush(&g_path, cell);
+}
 
-    g_should_animate = 1;
+void
+animateStart(void)
+{
+    g_should_animate = g_path.count > 0;
 }
 
 void
@@ -28,14 +33,48 @@ animatePath(void)
 {
     if (g_should_animate == 0) return;
 
-    if (sllGetNodeCount(&g_path) == 0)
+    if (g_path_drawn == g_path.count)
     {
         g_should_animate = 0;
-        sllDelete(&g_path);
         return;
     }
 
-    Cell** cell_ptr     = (Cell**)g_path.tail->data;
-    (*cell_ptr)->color  = CELL_SOLUTION_COLOR;
-    sllDeleteTail(&g_path);
-}
\ No newline at end of file
+    gridBitSet(g_path_cells, g_path.cells[g_path_drawn]);
+    g_path_drawn += 1;
+}
+
+void
+animateClear(void)
+{
+    free(g_path_cells);
+    searchPathClear(&g_path);
+
+    g_path_cells     = NULL;
+    g_path_drawn     = 0;
+    g_should_animate = 0;
+}
+
+void
+animateDestroy(void)
+{
+    animateClear();
+    searchPathFree(&g_path);
+}
+
+b8
+animateIsOnPath(u32 cell)
+{
+    return g_path_cells != NULL && gridBitTest(g_path_cells, cell);
+}
+
+const u64*
+animateGetPathCells(void)
+{
+    return g_path_cells;
+}
+
+const SearchPath*
+animateGetPath(void)
+{
+    return &g_path;
+}
@@ -0,0 +1,388 @@
+#include "bfs_parallel.h"
+
+#include "logger.h"
+
+#include "grid_neighbors.h"
+#include "search.h"
+#include "search_batch.h"
+#include "thread_barrier.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Direction switches (Beamer et al.): bottom-up once a growing frontier holds
+// more than 1 / BFS_ALPHA of the unreached cells, top-down again once a
+// shrinking one falls below 1 / BFS_BETA of the grid
+#define BFS_ALPHA   14
+#define BFS_BETA    24
+
+typedef enum {
+    BFS_TOP_DOWN    = 0,
+    BFS_BOTTOM_UP   = 1
+} BfsDirection;
+
+typedef struct BfsParallel BfsParallel;
+
+typedef struct BfsWorker
+{
+    pthread_t           thread;
+    BfsParallel*        bfs;
+    u32                 id;
+
+    // Cells this worker reached in the current level
+    u32*                next;
+    u64                 next_size;
+    u64                 next_capacity;
+} BfsWorker;
+
+struct BfsParallel
+{
+    const Grid*         grid;
+    u64                 cell_count;
+    u64                 word_count;
+    u32*                distance;
+    u32*                parent;         // NULL when not wanted
+    u64*                visited;
+    b8                  owns_visited;
+    u32                 goal;           // GRID_NO_CELL explores everything reachable
+
+    u32*                frontier;
+    u64                 frontier_size;
+    u64                 previous_size;
+    u64*                frontier_bits;  // bottom-up levels only
+    u64                 unreached;      // open cells not reached yet
+    u32                 level;
+    BfsDirection        direction;
+
+    BfsWorker*          workers;
+    u32                 worker_count;
+    ThreadBarrier       start;          // a level begins
+    ThreadBarrier       phase;          // between the bottom-up phases
+    ThreadBarrier       end;            // a level is done
+    b8                  is_stopping;
+};
+
+static BfsParallel  g_bfs_parallel              = {0};
+static b8           g_bfs_parallel_is_running   = 0;
+static b8           g_bfs_parallel_has_finished = 0;
+
+// Sets the bit and returns 1 if this thread was the one to set it
+static b8
+claim(u64* bits, u32 cell)
+{
+    u64 mask = 1ull << (cell & 63);
+
+    if ((__atomic_load_n(&bits[cell >> 6], __ATOMIC_RELAXED) & mask) != 0) return 0;
+
+    return (__atomic_fetch_or(&bits[cell >> 6], mask, __ATOMIC_RELAXED) & mask) == 0;
+}
+
+static void
+reach(BfsParallel* bfs, BfsWorker* worker, u32 cell, u32 from)
+{
+    bfs->distance[cell] = bfs->level + 1;
+    if (bfs->parent != NULL) bfs->parent[cell] = from;
+
+    if (worker->next_size == worker->next_capacity)
+    {
+        worker->next_capacity = worker->next_capacity > 0 ? worker->next_capacity * 2 : 1024;
+        worker->next          = realloc(worker->next, worker->next_capacity * sizeof(u32));
+    }
+
+    worker->next[worker->next_size++] = cell;
+}
+
+static void
+expand_top_down(BfsParallel* bfs, BfsWorker* worker)
+{
+    const Grid* grid  = bfs->grid;
+    u64         begin = bfs->frontier_size * worker->id / bfs->worker_count;
+    u64         end   = bfs->frontier_size * (worker->id + 1) / bfs->worker_count;
+
+    for (u64 i = begin; i < end; ++i)
+    {
+        u32 cell = bfs->frontier[i];
+
+        u32 neighbors[8];
+        u32 count = gridOpenNeighbors(grid, cell, GRID_CONNECT_4, neighbors, NULL);
+
+        for (u32 k = 0; k < count; ++k)
+        {
+            u32 neighbor = neighbors[k];
+            if (claim(bfs->visited, neighbor) == 0) continue;
+
+            reach(bfs, worker, neighbor, cell);
+        }
+    }
+}
+
+// Every worker owns a range of bitset words, so the visited and frontier
+// words it writes are never touched by another thread in the same phase
+static void
+expand_bottom_up(BfsParallel* bfs, BfsWorker* worker)
+{
+    const Grid* grid       = bfs->grid;
+    u64         word_begin = bfs->word_count * worker->id / bfs->worker_count;
+    u64         word_end   = bfs->word_count * (worker->id + 1) / bfs->worker_count;
+
+    memset(&bfs->frontier_bits[word_begin], 0, (word_end - word_begin) * sizeof(u64));
+    barrierWait(&bfs->phase);
+
+    u64 begin = bfs->frontier_size * worker->id / bfs->worker_count;
+    u64 end   = bfs->frontier_size * (worker->id + 1) / bfs->worker_count;
+
+    for (u64 i = begin; i < end; ++i)
+    {
+        u32 cell = bfs->frontier[i];
+        __atomic_fetch_or(&bfs->frontier_bits[cell >> 6], 1ull << (cell & 63), __ATOMIC_RELAXED);
+    }
+    barrierWait(&bfs->phase);
+
+    for (u64 word = word_begin; word < word_end; ++word)
+    {
+        u64 open = ~bfs->visited[word] & ~grid->wall[word];
+        if (word == bfs->word_count - 1 && bfs->cell_count % 64 != 0) open &= (1ull << (bfs->cell_count % 64)) - 1;
+
+        while (open != 0)
+        {
+            u32 cell = word * 64 + __builtin_ctzll(open);
+            open    &= open - 1;
+
+            u32 neighbors[8];
+            u32 count = gridOpenNeighbors(grid, cell, GRID_CONNECT_4, neighbors, NULL);
+
+            for (u32 k = 0; k < count; ++k)
+            {
+                if (gridBitTest(bfs->frontier_bits, neighbors[k]) == 0) continue;
+
+                bfs->visited[word] |= 1ull << (cell & 63);
+                reach(bfs, worker, cell, neighbors[k]);
+                break;
+            }
+        }
+    }
+}
+
+static void
+expand(BfsParallel* bfs, BfsWorker* worker)
+{
+    worker->next_size = 0;
+
+    if (bfs->direction == BFS_TOP_DOWN) expand_top_down(bfs, worker);
+    else                                expand_bottom_up(bfs, worker);
+}
+
+static void*
+worker_main(void* argument)
+{
+    BfsWorker*   worker = argument;
+    BfsParallel* bfs    = worker->bfs;
+
+    for (;;)
+    {
+        barrierWait(&bfs->start);
+        if (bfs->is_stopping == 1) break;
+
+        expand(bfs, worker);
+        barrierWait(&bfs->end);
+    }
+
+    return NULL;
+}
+
+static void
+create(BfsParallel* bfs, const Grid* grid, u32 source, u32 goal,
+       u32* distance, u32* parent, u64* visited, u32 threads)
+{
+    u64 cell_count = (u64)grid->rows * grid->cols;
+    u64 word_count = (cell_count + 63) / 64;
+
+    *bfs = (BfsParallel){
+        .grid           = grid,
+        .cell_count     = cell_count,
+        .word_count     = word_count,
+        .distance       = distance,
+        .parent         = parent,
+        .visited        = visited != NULL ? visited : calloc(word_count, sizeof(u64)),
+        .owns_visited   = visited == NULL,
+        .goal           = goal,
+        .frontier       = malloc(cell_count * sizeof(u32)),
+        .frontier_size  = 1,
+        .frontier_bits  = calloc(word_count, sizeof(u64)),
+        .direction      = BFS_TOP_DOWN,
+        .worker_count   = threads > 0 ? threads : searchBatchDefaultThreads()
+    };
+
+    u64 walls = 0;
+    for (u64 i = 0; i < word_count; ++i) walls += __builtin_popcountll(grid->wall[i]);
+    bfs->unreached = cell_count - walls - 1;
+
+    bfs->frontier[0]      = source;
+    bfs->distance[source] = 0;
+    if (parent != NULL) parent[source] = GRID_NO_CELL;
+    gridBitSet(bfs->visited, source);
+
+    barrierInit(&bfs->start, bfs->worker_count);
+    barrierInit(&bfs->phase, bfs->worker_count);
+    barrierInit(&bfs->end,   bfs->worker_count);
+
+    bfs->workers = calloc(bfs->worker_count, sizeof(BfsWorker));
+    for (u32 i = 0; i < bfs->worker_count; ++i)
+    {
+        bfs->workers[i].bfs = bfs;
+        bfs->workers[i].id  = i;
+    }
+
+    // The calling thread works as worker 0
+    for (u32 i = 1; i < bfs->worker_count; ++i) pthread_create(&bfs->workers[i].thread, NULL, worker_main, &bfs->workers[i]);
+}
+
+static void
+destroy(BfsParallel* bfs)
+{
+    bfs->is_stopping = 1;
+    barrierWait(&bfs->start);
+
+    for (u32 i = 1; i < bfs->worker_count; ++i) pthread_join(bfs->workers[i].thread, NULL);
+    for (u32 i = 0; i < bfs->worker_count; ++i) free(bfs->workers[i].next);
+
+    barrierDestroy(&bfs->start);
+    barrierDestroy(&bfs->phase);
+    barrierDestroy(&bfs->end);
+
+    if (bfs->owns_visited == 1) free(bfs->visited);
+    free(bfs->frontier);
+    free(bfs->frontier_bits);
+    free(bfs->workers);
+
+    *bfs = (BfsParallel){0};
+}
+
+// Expands one level and replaces the frontier with the cells it reached
+static void
+expand_level(BfsParallel* bfs)
+{
+    if (bfs->direction == BFS_TOP_DOWN && bfs->frontier_size > bfs->unreached / BFS_ALPHA &&
+        bfs->frontier_size > bfs->previous_size)
+    {
+        bfs->direction = BFS_BOTTOM_UP;
+        LOG_DEBUG("Parallel BFS: bottom-up from level %u", bfs->level);
+    }
+    else if (bfs->direction == BFS_BOTTOM_UP && bfs->frontier_size < bfs->cell_count / BFS_BETA &&
+             bfs->frontier_size < bfs->previous_size)
+    {
+        bfs->direction = BFS_TOP_DOWN;
+        LOG_DEBUG("Parallel BFS: top-down from level %u", bfs->level);
+    }
+
+    barrierWait(&bfs->start);
+    expand(bfs, &bfs->workers[0]);
+    barrierWait(&bfs->end);
+
+    u64 size = 0;
+    for (u32 i = 0; i < bfs->worker_count; ++i)
+    {
+        BfsWorker* worker = &bfs->workers[i];
+
+        // A worker that reached nothing may never have allocated its list
+        if (worker->next_size == 0) continue;
+
+        memcpy(&bfs->frontier[size], worker->next, worker->next_size * sizeof(u32));
+        size += worker->next_size;
+    }
+
+    bfs->previous_size  = bfs->frontier_size;
+    bfs->frontier_size  = size;
+    bfs->unreached     -= size;
+    bfs->level         += 1;
+}
+
+static void
+finish(void)
+{
+    destroy(&g_bfs_parallel);
+
+    g_bfs_parallel_is_running    = 0;
+    g_bfs_parallel_has_finished  = 1;
+}
+
+void
+bfsParallelInit(u32 threads)
+{
+    Grid* grid = gridGet();
+
+    // A search abandoned halfway still has its workers waiting
+    if (g_bfs_parallel_is_running == 1) finish();
+
+    // Workers write distance and parent without stamping, start from a clean grid
+    gridTouchAll();
+
+    create(&g_bfs_parallel, grid, grid->start, grid->goal, grid->distance, grid->parent, grid->visited, threads);
+    searchStatsQueuePush(searchGetStats(), 1);
+
+    LOG_DEBUG("Parallel BFS on %u threads", g_bfs_parallel.worker_count);
+
+    g_bfs_parallel_is_running    = 1;
+    g_bfs_parallel_has_finished  = 0;
+
+    if (grid->start == grid->goal)
+    {
+        LOG_INFO("Found path!");
+        finish();
+    }
+}
+
+void
+bfsParallelStep(void)
+{
+    if (g_bfs_parallel_is_running == 0 || g_bfs_parallel_has_finished == 1) return;
+
+    Grid*        grid  = gridGet();
+    SearchStats* stats = searchGetStats();
+
+    stats->expanded += g_bfs_parallel.frontier_size;
+    expand_level(&g_bfs_parallel);
+    stats->pushes += g_bfs_parallel.frontier_size;
+    searchStatsSetFrontier(stats, g_bfs_parallel.frontier_size);
+
+    if (gridIsVisited(grid, grid->goal) == 1)
+    {
+        LOG_INFO("Found path!");
+        LOG_INFO("Distance %u", grid->distance[grid->goal]);
+        finish();
+    }
+    else if (g_bfs_parallel.frontier_size == 0)
+    {
+        LOG_INFO("Could not find path!");
+        finish();
+    }
+}
+
+b8
+bfsParallelShouldStop(void)
+{
+    return (g_bfs_parallel_is_running == 0) && (g_bfs_parallel_has_finished == 1);
+}
+
+void
+bfsParallelDistanceMap(const Grid* grid, u32 source, u32* distance, u32* parent, u32 threads)
+{
+    u64 cell_count = (u64)grid->rows * grid->cols;
+
+    if (grid->moves == NULL)
+    {
+        LOG_ERROR("Grid moves aren't built, call gridBuildMoves() first");
+        return;
+    }
+
+    memset(distance, 0xFF, cell_count * sizeof(u32));
+    if (parent != NULL) memset(parent, 0xFF, cell_count * sizeof(u32));
+
+    BfsParallel bfs;
+    create(&bfs, grid, source, GRID_NO_CELL, distance, parent, NULL, threads);
+
+    while (bfs.frontier_size > 0) expand_level(&bfs);
+
+    destroy(&bfs);
+}
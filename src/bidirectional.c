@@ -0,0 +1,366 @@
+#include "bidirectional.h"
+
+#include "logger.h"
+#include "ds/queue.h"
+
+#include "grid.h"
+#include "grid_neighbors.h"
+
+#include <stdlib.h>
+
+#define BIDIR_FORWARD   0
+#define BIDIR_BACKWARD  1
+
+static SearchAlgo    g_bidir_base           = ALGO_NONE;
+static b8            g_bidir_is_running     = 0;
+static b8            g_bidir_has_finished   = 0;
+
+// Per side: BFS uses the FIFO queues, Dijkstra and A* the priority queues
+static Queue         g_bidir_fifo[2]        = {0};
+static PriorityQueue g_bidir_queue[2]       = {0};
+static u64           g_bidir_frontier[2]    = {0};
+static u32           g_bidir_last_key[2]    = {0};
+
+// Forward distance and parent are the grid's own arrays, the backward parent
+// of a cell is its next cell towards the goal. The backward arrays are kept
+// between searches and share the grid's stamps, so a query only resets the
+// cells it reaches.
+static u32*          g_bidir_distance[2]    = {0};
+static u32*          g_bidir_parent[2]      = {0};
+static u64           g_bidir_cell_count     = 0;
+
+// Kept between searches too, the cells closed on either side are listed so
+// the next search clears only their bits
+static u64*          g_bidir_closed[2]      = {0};
+static u32*          g_bidir_closed_list    = NULL;
+static u64           g_bidir_list_count     = 0;
+static u64           g_bidir_list_capacity  = 0;
+
+// BFS expands whole levels so the first meeting is a shortest path
+static u8            g_bidir_side           = BIDIR_FORWARD;
+static u64           g_bidir_level_left     = 0;
+
+// Best start-to-goal cost through a cell reached from both sides so far
+static u64           g_bidir_best           = UINT64_MAX;
+static u32           g_bidir_meet           = GRID_NO_CELL;
+
+// Front-to-end heuristic: the forward side aims at the goal, the backward side at the start
+static u32
+heuristic(const Grid* grid, u8 side, u32 cell)
+{
+    if (g_bidir_base != ALGO_ASTAR) return 0;
+
+    return gridManhattanDistance(grid, cell, side == BIDIR_FORWARD ? grid->goal : grid->start);
+}
+
+// gridTouch() for both sides: a cell left over from an earlier search starts
+// unreached from either end
+static void
+touch(Grid* grid, u32 cell)
+{
+    if (grid->stamp[cell] == grid->epoch) return;
+
+    g_bidir_distance[BIDIR_BACKWARD][cell] = GRID_INFINITY;
+    g_bidir_parent[BIDIR_BACKWARD][cell]   = GRID_NO_CELL;
+    gridTouch(grid, cell);
+}
+
+// Shows both sides as visited. The goal is left out until the sides meet,
+// searchHasFoundPath() reads it.
+static void
+mark_closed(Grid* grid, u8 side, u32 cell)
+{
+    if (g_bidir_list_count == g_bidir_list_capacity)
+    {
+        g_bidir_list_capacity = g_bidir_list_capacity == 0 ? 64 : 2 * g_bidir_list_capacity;
+        g_bidir_closed_list   = realloc(g_bidir_closed_list, g_bidir_list_capacity * sizeof(u32));
+    }
+
+    g_bidir_closed_list[g_bidir_list_count++] = cell;
+    gridBitSet(g_bidir_closed[side], cell);
+    if (cell != grid->goal) gridMarkVisited(grid, cell);
+}
+
+// Turns the backward half of the path into forward parents, from the meeting cell to the goal
+static void
+join_paths(Grid* grid)
+{
+    u32 previous = g_bidir_meet;
+    u32 cell     = g_bidir_parent[BIDIR_BACKWARD][g_bidir_meet];
+
+    while (cell != GRID_NO_CELL)
+    {
+        grid->parent[cell] = previous;
+        previous           = cell;
+        cell               = g_bidir_parent[BIDIR_BACKWARD][cell];
+    }
+}
+
+// Frees the frontiers, which base decides the kind of
+static void
+release(void)
+{
+    for (u8 side = 0; side < 2; ++side)
+    {
+        if (g_bidir_base == ALGO_BFS)   qDestroy(&g_bidir_fifo[side]);
+        else                            pqDestroy(&g_bidir_queue[side]);
+    }
+}
+
+// Sizes the kept arrays for the grid and clears the closed bits of the last search
+static void
+prepare(u64 cell_count)
+{
+    if (cell_count != g_bidir_cell_count)
+    {
+        for (u8 side = 0; side < 2; ++side)
+        {
+            free(g_bidir_closed[side]);
+            g_bidir_closed[side] = calloc((cell_count + 63) / 64, sizeof(u64));
+        }
+
+        g_bidir_distance[BIDIR_BACKWARD] = realloc(g_bidir_distance[BIDIR_BACKWARD], cell_count * sizeof(u32));
+        g_bidir_parent[BIDIR_BACKWARD]   = realloc(g_bidir_parent[BIDIR_BACKWARD], cell_count * sizeof(u32));
+        g_bidir_cell_count               = cell_count;
+        g_bidir_list_count               = 0;
+    }
+
+    for (u64 i = 0; i < g_bidir_list_count; ++i)
+    {
+        gridBitClear(g_bidir_closed[BIDIR_FORWARD],  g_bidir_closed_list[i]);
+        gridBitClear(g_bidir_closed[BIDIR_BACKWARD], g_bidir_closed_list[i]);
+    }
+
+    g_bidir_list_count = 0;
+}
+
+static void
+finish(Grid* grid, b8 found)
+{
+    if (found == 1)
+    {
+        join_paths(grid);
+        gridMarkVisited(grid, grid->goal);
+
+        if (g_bidir_base != ALGO_BFS) grid->distance[grid->goal] = g_bidir_best;
+
+        LOG_INFO("Found path!");
+        LOG_INFO("Sides met at row %u col %u", g_bidir_meet / grid->cols, g_bidir_meet % grid->cols);
+    }
+    else
+    {
+        LOG_INFO("Could not find path!");
+    }
+
+    release();
+
+    g_bidir_is_running    = 0;
+    g_bidir_has_finished  = 1;
+}
+
+void
+bidirInit(SearchAlgo base, u64 capacity, PriorityQueueKind queue)
+{
+    Grid* grid       = gridGet();
+    u64   cell_count = gridGetCellCount();
+
+    // A search cancelled or restarted before it finished, released with its own base
+    if (g_bidir_is_running == 1) release();
+
+    g_bidir_base = base;
+    g_bidir_best = UINT64_MAX;
+    g_bidir_meet = GRID_NO_CELL;
+
+    prepare(cell_count);
+
+    g_bidir_distance[BIDIR_FORWARD]  = grid->distance;
+    g_bidir_parent[BIDIR_FORWARD]    = grid->parent;
+
+    // Keys grow by at most one weight per step, plus one for the Manhattan heuristic
+    u32 max_key_step = grid->max_weight + (base == ALGO_ASTAR ? 1 : 0);
+
+    for (u8 side = 0; side < 2; ++side)
+    {
+        u32 root = side == BIDIR_FORWARD ? grid->start : grid->goal;
+
+        touch(grid, root);
+        g_bidir_distance[side][root] = 0;
+        g_bidir_last_key[side]       = 0;
+
+        if (base == ALGO_BFS)
+        {
+            g_bidir_fifo[side] = qCreate(capacity);
+            qEnqueue(&g_bidir_fifo[side], &root, sizeof(u32));
+            mark_closed(grid, side, root);
+        }
+        else
+        {
+            g_bidir_queue[side] = pqCreate(queue, capacity, max_key_step);
+            pqPush(&g_bidir_queue[side], root, heuristic(grid, side, root));
+        }
+
+        g_bidir_frontier[side] = 1;
+    }
+
+    g_bidir_side       = BIDIR_FORWARD;
+    g_bidir_level_left = 0;
+
+    // Both roots are in a frontier
+    searchGetStats()->pushes = 2;
+    searchStatsSetFrontier(searchGetStats(), 2);
+
+    g_bidir_is_running    = 1;
+    g_bidir_has_finished  = 0;
+
+    if (grid->start == grid->goal)
+    {
+        g_bidir_best = 0;
+        g_bidir_meet = grid->goal;
+        finish(grid, 1);
+    }
+}
+
+static void
+bfs_step(Grid* grid, SearchStats* stats)
+{
+    // Start the next level on the side with the smaller frontier
+    if (g_bidir_level_left == 0)
+    {
+        if (g_bidir_frontier[BIDIR_FORWARD] == 0 || g_bidir_frontier[BIDIR_BACKWARD] == 0)
+        {
+            finish(grid, 0);
+            return;
+        }
+
+        g_bidir_side       = g_bidir_frontier[BIDIR_FORWARD] <= g_bidir_frontier[BIDIR_BACKWARD] ? BIDIR_FORWARD : BIDIR_BACKWARD;
+        g_bidir_level_left = g_bidir_frontier[g_bidir_side];
+    }
+
+    u8 side  = g_bidir_side;
+    u8 other = side ^ 1;
+
+    u32 cell;
+    qDequeue(&g_bidir_fifo[side], &cell, sizeof(u32));
+    g_bidir_frontier[side] -= 1;
+    g_bidir_level_left     -= 1;
+    searchStatsPop(stats);
+    stats->expanded += 1;
+
+    u32 neighbors[8];
+    u32 count = gridOpenNeighbors(grid, cell, GRID_CONNECT_4, neighbors, NULL);
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        u32 neighbor = neighbors[i];
+        touch(grid, neighbor);
+
+        // The other side already reached it: the sides meet
+        if (gridBitTest(g_bidir_closed[other], neighbor) == 1)
+        {
+            g_bidir_parent[side][neighbor] = cell;
+            g_bidir_meet                   = neighbor;
+            finish(grid, 1);
+            return;
+        }
+
+        if (gridBitTest(g_bidir_closed[side], neighbor) == 1) continue;
+
+        mark_closed(grid, side, neighbor);
+        g_bidir_parent[side][neighbor] = cell;
+
+        qEnqueue(&g_bidir_fifo[side], &neighbor, sizeof(u32));
+        g_bidir_frontier[side] += 1;
+        searchStatsPush(stats);
+    }
+}
+
+static void
+priority_step(Grid* grid, SearchStats* stats)
+{
+    if (pqIsEmpty(&g_bidir_queue[BIDIR_FORWARD]) == 1 || pqIsEmpty(&g_bidir_queue[BIDIR_BACKWARD]) == 1)
+    {
+        finish(grid, g_bidir_best != UINT64_MAX);
+        return;
+    }
+
+    u8 side  = g_bidir_queue[BIDIR_FORWARD].size <= g_bidir_queue[BIDIR_BACKWARD].size ? BIDIR_FORWARD : BIDIR_BACKWARD;
+    u8 other = side ^ 1;
+
+    PQEntry entry;
+    pqPop(&g_bidir_queue[side], &entry);
+    searchStatsSetFrontier(stats, g_bidir_queue[BIDIR_FORWARD].size + g_bidir_queue[BIDIR_BACKWARD].size);
+
+    // Popped keys never decrease, so the last one is a lower bound of the queue.
+    // Dijkstra: no path through an unsettled cell beats the sum of both bounds.
+    // A*: no path found later beats either bound (front-to-end).
+    g_bidir_last_key[side] = entry.priority;
+
+    u64 bound = g_bidir_base == ALGO_ASTAR
+        ? entry.priority
+        : (u64)g_bidir_last_key[BIDIR_FORWARD] + g_bidir_last_key[BIDIR_BACKWARD];
+
+    if (bound >= g_bidir_best)
+    {
+        finish(grid, 1);
+        return;
+    }
+
+    u32 cell = entry.cell;
+    if (gridBitTest(g_bidir_closed[side], cell) == 1)
+    {
+        stats->stale_pops += 1;
+        return;
+    }
+    mark_closed(grid, side, cell);
+    stats->expanded += 1;
+
+    u32* distance = g_bidir_distance[side];
+
+    u32 neighbors[8];
+    u32 count = gridOpenNeighbors(grid, cell, GRID_CONNECT_4, neighbors, NULL);
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        u32 neighbor = neighbors[i];
+        if (gridBitTest(g_bidir_closed[side], neighbor) == 1) continue;
+
+        touch(grid, neighbor);
+
+        // Entering a cell costs its weight, backwards that is the cell being left
+        u32 weight = side == BIDIR_FORWARD ? grid->weight[neighbor] : grid->weight[cell];
+        u64 temp   = (u64)distance[cell] + weight;
+
+        if (temp < distance[neighbor])
+        {
+            distance[neighbor]             = temp;
+            g_bidir_parent[side][neighbor] = cell;
+            pqPush(&g_bidir_queue[side], neighbor, temp + heuristic(grid, side, neighbor));
+            searchStatsQueuePush(stats, g_bidir_queue[BIDIR_FORWARD].size + g_bidir_queue[BIDIR_BACKWARD].size);
+
+            u32 across = g_bidir_distance[other][neighbor];
+            if (across != GRID_INFINITY && temp + across < g_bidir_best)
+            {
+                g_bidir_best = temp + across;
+                g_bidir_meet = neighbor;
+            }
+        }
+    }
+}
+
+void
+bidirStep(void)
+{
+    if (g_bidir_is_running == 0 || g_bidir_has_finished == 1) return;
+
+    Grid*        grid  = gridGet();
+    SearchStats* stats = searchGetStats();
+
+    if (g_bidir_base == ALGO_BFS)   bfs_step(grid, stats);
+    else                            priority_step(grid, stats);
+}
+
+b8
+bidirShouldStop(void)
+{
+    return (g_bidir_is_running == 0) && (g_bidir_has_finished == 1);
+}
@@ -0,0 +1,460 @@
+#include "delta_stepping.h"
+
+#include "logger.h"
+
+#include "grid_neighbors.h"
+#include "search.h"
+#include "search_batch.h"
+#include "thread_barrier.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum {
+    DELTA_LIGHT     = 0,    // relax the light edges of the frontier
+    DELTA_HEAVY     = 1,    // relax the heavy edges of the cells the bucket settled
+    DELTA_UNPACK    = 2     // copy the tentative distances and parents out
+} DeltaPhase;
+
+typedef struct DeltaList
+{
+    u32*    cells;
+    u64     size;
+    u64     capacity;
+} DeltaList;
+
+typedef struct DeltaStepping DeltaStepping;
+
+typedef struct DeltaWorker
+{
+    pthread_t           thread;
+    DeltaStepping*      ds;
+    u32                 id;
+
+    DeltaList*          buckets;    // cells this worker improved, by bucket
+    DeltaList           settled;    // cells this worker settled in the current bucket
+    u64                 expanded;
+    u64                 pushes;
+} DeltaWorker;
+
+struct DeltaStepping
+{
+    const Grid*         grid;
+    u64                 cell_count;
+    u32*                distance;
+    u32*                parent;         // NULL when not wanted
+    u64*                settled;        // 1 bit per cell
+    b8                  owns_settled;
+
+    // Distance in the high half, parent in the low half, so both change in a
+    // single compare-and-swap and always agree
+    u64*                tentative;
+
+    u32                 delta;
+    u32                 bucket_count;   // live buckets never span more than max_weight / delta + 2
+    u64                 current;        // index of the bucket being settled
+    u64                 pushes;         // bucket entries the workers added so far
+
+    DeltaList           frontier;
+    DeltaPhase          phase;
+
+    DeltaWorker*        workers;
+    u32                 worker_count;
+    ThreadBarrier       start;
+    ThreadBarrier       end;
+    b8                  is_stopping;
+};
+
+static DeltaStepping g_delta                = {0};
+static b8            g_delta_is_running     = 0;
+static b8            g_delta_has_finished   = 0;
+
+static void
+list_push(DeltaList* list, u32 cell)
+{
+    if (list->size == list->capacity)
+    {
+        list->capacity = list->capacity > 0 ? list->capacity * 2 : 1024;
+        list->cells    = realloc(list->cells, list->capacity * sizeof(u32));
+    }
+
+    list->cells[list->size++] = cell;
+}
+
+static void
+list_append(DeltaList* list, const DeltaList* other)
+{
+    // An empty list may never have allocated its cells
+    if (other->size == 0) return;
+
+    if (list->size + other->size > list->capacity)
+    {
+        list->capacity = list->size + other->size;
+        list->cells    = realloc(list->cells, list->capacity * sizeof(u32));
+    }
+
+    memcpy(&list->cells[list->size], other->cells, other->size * sizeof(u32));
+    list->size += other->size;
+}
+
+// Lowers the tentative distance of a cell, returns 1 if this call lowered it
+static b8
+relax(u64* slot, u32 distance, u32 parent)
+{
+    u64 desired = (u64)distance << 32 | parent;
+    u64 current = __atomic_load_n(slot, __ATOMIC_RELAXED);
+
+    while ((u32)(current >> 32) > distance)
+    {
+        if (__atomic_compare_exchange_n(slot, &current, desired, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) return 1;
+    }
+
+    return 0;
+}
+
+static void
+relax_edges(DeltaStepping* ds, DeltaWorker* worker, u32 cell, u32 distance, b8 light)
+{
+    const Grid* grid = ds->grid;
+
+    u32 neighbors[8];
+    u32 count = gridOpenNeighbors(grid, cell, GRID_CONNECT_4, neighbors, NULL);
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        u32 neighbor = neighbors[i];
+        u32 weight   = grid->weight[neighbor];
+
+        if ((weight <= ds->delta) != light) continue;
+
+        u64 temp = (u64)distance + weight;
+        if (temp >= GRID_INFINITY || relax(&ds->tentative[neighbor], temp, cell) == 0) continue;
+
+        list_push(&worker->buckets[(temp / ds->delta) % ds->bucket_count], neighbor);
+        worker->pushes += 1;
+    }
+}
+
+static void
+run_light(DeltaStepping* ds, DeltaWorker* worker)
+{
+    u64 begin = ds->frontier.size * worker->id / ds->worker_count;
+    u64 end   = ds->frontier.size * (worker->id + 1) / ds->worker_count;
+
+    for (u64 i = begin; i < end; ++i)
+    {
+        u32 cell     = ds->frontier.cells[i];
+        u32 distance = __atomic_load_n(&ds->tentative[cell], __ATOMIC_RELAXED) >> 32;
+
+        // Left behind in this bucket when the cell moved to a lower one
+        if (distance / ds->delta != ds->current) continue;
+
+        u64 mask = 1ull << (cell & 63);
+        if ((__atomic_fetch_or(&ds->settled[cell >> 6], mask, __ATOMIC_RELAXED) & mask) == 0)
+        {
+            list_push(&worker->settled, cell);
+        }
+
+        worker->expanded += 1;
+        relax_edges(ds, worker, cell, distance, 1);
+    }
+}
+
+// Heavy edges land in later buckets, so they only need relaxing once the
+// distances of the bucket are final
+static void
+run_heavy(DeltaStepping* ds, DeltaWorker* worker)
+{
+    u64 begin = ds->frontier.size * worker->id / ds->worker_count;
+    u64 end   = ds->frontier.size * (worker->id + 1) / ds->worker_count;
+
+    for (u64 i = begin; i < end; ++i)
+    {
+        u32 cell = ds->frontier.cells[i];
+        relax_edges(ds, worker, cell, ds->tentative[cell] >> 32, 0);
+    }
+}
+
+static void
+run_unpack(DeltaStepping* ds, DeltaWorker* worker)
+{
+    u64 begin = ds->cell_count * worker->id / ds->worker_count;
+    u64 end   = ds->cell_count * (worker->id + 1) / ds->worker_count;
+
+    for (u64 cell = begin; cell < end; ++cell)
+    {
+        ds->distance[cell] = ds->tentative[cell] >> 32;
+        if (ds->parent != NULL) ds->parent[cell] = (u32)ds->tentative[cell];
+    }
+}
+
+static void
+run_phase_part(DeltaStepping* ds, DeltaWorker* worker)
+{
+    switch (ds->phase)
+    {
+        case DELTA_LIGHT:   run_light(ds, worker);  break;
+        case DELTA_HEAVY:   run_heavy(ds, worker);  break;
+        case DELTA_UNPACK:  run_unpack(ds, worker); break;
+        default:                                    break;
+    }
+}
+
+static void*
+worker_main(void* argument)
+{
+    DeltaWorker*   worker = argument;
+    DeltaStepping* ds     = worker->ds;
+
+    for (;;)
+    {
+        barrierWait(&ds->start);
+        if (ds->is_stopping == 1) break;
+
+        run_phase_part(ds, worker);
+        barrierWait(&ds->end);
+    }
+
+    return NULL;
+}
+
+static void
+run_phase(DeltaStepping* ds, DeltaPhase phase)
+{
+    ds->phase = phase;
+
+    barrierWait(&ds->start);
+    run_phase_part(ds, &ds->workers[0]);
+    barrierWait(&ds->end);
+}
+
+static void
+create(DeltaStepping* ds, const Grid* grid, u32 source, u32 delta,
+       u32* distance, u32* parent, u64* settled, u32 threads)
+{
+    u64 cell_count = (u64)grid->rows * grid->cols;
+    u64 word_count = (cell_count + 63) / 64;
+
+    if (delta == 0) delta = grid->max_weight;
+
+    *ds = (DeltaStepping){
+        .grid           = grid,
+        .cell_count     = cell_count,
+        .distance       = distance,
+        .parent         = parent,
+        .settled        = settled != NULL ? settled : calloc(word_count, sizeof(u64)),
+        .owns_settled   = settled == NULL,
+        .tentative      = malloc(cell_count * sizeof(u64)),
+        .delta          = delta,
+        .bucket_count   = grid->max_weight / delta + 2,
+        .current        = 0,
+        .worker_count   = threads > 0 ? threads : searchBatchDefaultThreads()
+    };
+
+    memset(ds->tentative, 0xFF, cell_count * sizeof(u64));
+    ds->tentative[source] = (u64)GRID_NO_CELL;
+
+    barrierInit(&ds->start, ds->worker_count);
+    barrierInit(&ds->end,   ds->worker_count);
+
+    ds->workers = calloc(ds->worker_count, sizeof(DeltaWorker));
+    for (u32 i = 0; i < ds->worker_count; ++i)
+    {
+        ds->workers[i].ds      = ds;
+        ds->workers[i].id      = i;
+        ds->workers[i].buckets = calloc(ds->bucket_count, sizeof(DeltaList));
+    }
+
+    list_push(&ds->workers[0].buckets[0], source);
+
+    // The calling thread works as worker 0
+    for (u32 i = 1; i < ds->worker_count; ++i) pthread_create(&ds->workers[i].thread, NULL, worker_main, &ds->workers[i]);
+}
+
+static void
+destroy(DeltaStepping* ds)
+{
+    ds->is_stopping = 1;
+    barrierWait(&ds->start);
+
+    for (u32 i = 1; i < ds->worker_count; ++i) pthread_join(ds->workers[i].thread, NULL);
+
+    for (u32 i = 0; i < ds->worker_count; ++i)
+    {
+        DeltaWorker* worker = &ds->workers[i];
+
+        for (u32 b = 0; b < ds->bucket_count; ++b) free(worker->buckets[b].cells);
+        free(worker->buckets);
+        free(worker->settled.cells);
+    }
+
+    barrierDestroy(&ds->start);
+    barrierDestroy(&ds->end);
+
+    if (ds->owns_settled == 1) free(ds->settled);
+    free(ds->tentative);
+    free(ds->frontier.cells);
+    free(ds->workers);
+
+    *ds = (DeltaStepping){0};
+}
+
+// Moves current to the first bucket with entries, 0 once every bucket is empty
+static b8
+find_bucket(DeltaStepping* ds)
+{
+    for (u32 offset = 0; offset < ds->bucket_count; ++offset)
+    {
+        u32 slot = (ds->current + offset) % ds->bucket_count;
+
+        for (u32 i = 0; i < ds->worker_count; ++i)
+        {
+            if (ds->workers[i].buckets[slot].size == 0) continue;
+
+            ds->current += offset;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+// Settles the current bucket, returns the number of cells expanded
+static u64
+settle_bucket(DeltaStepping* ds)
+{
+    u32 slot     = ds->current % ds->bucket_count;
+    u64 expanded = 0;
+
+    // Light edges can refill the bucket, repeat until it stays empty
+    for (;;)
+    {
+        ds->frontier.size = 0;
+        for (u32 i = 0; i < ds->worker_count; ++i)
+        {
+            list_append(&ds->frontier, &ds->workers[i].buckets[slot]);
+            ds->workers[i].buckets[slot].size = 0;
+        }
+
+        if (ds->frontier.size == 0) break;
+
+        run_phase(ds, DELTA_LIGHT);
+    }
+
+    ds->frontier.size = 0;
+    for (u32 i = 0; i < ds->worker_count; ++i)
+    {
+        DeltaWorker* worker = &ds->workers[i];
+
+        list_append(&ds->frontier, &worker->settled);
+        worker->settled.size  = 0;
+        expanded             += worker->expanded;
+        worker->expanded      = 0;
+    }
+
+    run_phase(ds, DELTA_HEAVY);
+
+    for (u32 i = 0; i < ds->worker_count; ++i)
+    {
+        ds->pushes            += ds->workers[i].pushes;
+        ds->workers[i].pushes  = 0;
+    }
+
+    ds->current += 1;
+
+    return expanded;
+}
+
+static u64
+queued_entries(const DeltaStepping* ds)
+{
+    u64 size = 0;
+    for (u32 i = 0; i < ds->worker_count; ++i)
+    {
+        for (u32 b = 0; b < ds->bucket_count; ++b) size += ds->workers[i].buckets[b].size;
+    }
+
+    return size;
+}
+
+static void
+finish(void)
+{
+    run_phase(&g_delta, DELTA_UNPACK);
+    destroy(&g_delta);
+
+    g_delta_is_running    = 0;
+    g_delta_has_finished  = 1;
+}
+
+void
+deltaSteppingInit(u32 delta, u32 threads)
+{
+    Grid* grid = gridGet();
+
+    // A search abandoned halfway still has its workers waiting
+    if (g_delta_is_running == 1) finish();
+
+    // Every cell is written when the search finishes, stamp them all up front
+    gridTouchAll();
+
+    create(&g_delta, grid, grid->start, delta, grid->distance, grid->parent, grid->visited, threads);
+    searchStatsQueuePush(searchGetStats(), 1);
+
+    LOG_DEBUG("Delta-stepping with delta %u on %u threads", g_delta.delta, g_delta.worker_count);
+
+    g_delta_is_running    = 1;
+    g_delta_has_finished  = 0;
+}
+
+void
+deltaSteppingStep(void)
+{
+    if (g_delta_is_running == 0 || g_delta_has_finished == 1) return;
+
+    Grid*        grid  = gridGet();
+    SearchStats* stats = searchGetStats();
+
+    if (find_bucket(&g_delta) == 0)
+    {
+        LOG_INFO("Could not find path!");
+        finish();
+        return;
+    }
+
+    stats->expanded += settle_bucket(&g_delta);
+    stats->pushes    = 1 + g_delta.pushes;
+    searchStatsSetFrontier(stats, queued_entries(&g_delta));
+
+    if (gridIsVisited(grid, grid->goal) == 1)
+    {
+        LOG_INFO("Found path!");
+        finish();
+        LOG_INFO("Distance %u", grid->distance[grid->goal]);
+    }
+}
+
+b8
+deltaSteppingShouldStop(void)
+{
+    return (g_delta_is_running == 0) && (g_delta_has_finished == 1);
+}
+
+void
+deltaSteppingDistanceMap(const Grid* grid, u32 source, u32 delta, u32* distance, u32* parent, u32 threads)
+{
+    if (grid->moves == NULL)
+    {
+        LOG_ERROR("Grid moves aren't built, call gridBuildMoves() first");
+        return;
+    }
+
+    DeltaStepping ds;
+    create(&ds, grid, source, delta, distance, parent, NULL, threads);
+
+    while (find_bucket(&ds) == 1) settle_bucket(&ds);
+
+    run_phase(&ds, DELTA_UNPACK);
+    destroy(&ds);
+}
@@ -1,332 +1,388 @@
 #include "grid.h"
 
 #include "logger.h"
-#include "ds/dynamic_array.h"
 
-#include "bfs.h"
-#include "dfs.h"
-#include "dijkstra.h"
-#include "a_star.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
 
-#define WINDOW_MARGIN 100
+static Grid g_grid = {
+    .start          = GRID_NO_CELL,
+    .goal           = GRID_NO_CELL,
+    .connectivity   = GRID_CONNECT_4
+};
 
-static DynamicArray g_grid  = {0};
-static Cell*        g_start = NULL;
-static Cell*        g_goal  = NULL;
-
-static u8           g_grid_rows = 0;
-static u8           g_grid_cols = 0;
+static u64
+bit_words(u64 cell_count)
+{
+    return (cell_count + 63) / 64;
+}
 
-typedef enum {
-    ALGO_NONE     = 0,
-    ALGO_BFS      = 1,
-    ALGO_DFS      = 2,
-    ALGO_DIJKSTRA = 3,
-    ALGO_ASTAR    = 4
-} ActiveAlgo;
+static b8
+is_open(u32 row, u32 col)
+{
+    return gridIsWall(&g_grid, row * g_grid.cols + col) == 0;
+}
 
-static ActiveAlgo g_active_algo = ALGO_NONE;
+// Moves out of a cell: a neighbor beyond the edge counts as a wall, and a
+// diagonal needs both cells beside it open
+static u8
+cell_moves(u32 row, u32 col)
+{
+    b8 left  = col > 0                  && is_open(row, col - 1);
+    b8 up    = row > 0                  && is_open(row - 1, col);
+    b8 right = col + 1 < g_grid.cols    && is_open(row, col + 1);
+    b8 down  = row + 1 < g_grid.rows    && is_open(row + 1, col);
+
+    u8 moves = 0;
+    if (left == 1)  moves |= GRID_MOVE_LEFT;
+    if (up == 1)    moves |= GRID_MOVE_UP;
+    if (right == 1) moves |= GRID_MOVE_RIGHT;
+    if (down == 1)  moves |= GRID_MOVE_DOWN;
+
+    if (up == 1   && left == 1  && is_open(row - 1, col - 1)) moves |= GRID_MOVE_UP_LEFT;
+    if (up == 1   && right == 1 && is_open(row - 1, col + 1)) moves |= GRID_MOVE_UP_RIGHT;
+    if (down == 1 && left == 1  && is_open(row + 1, col - 1)) moves |= GRID_MOVE_DOWN_LEFT;
+    if (down == 1 && right == 1 && is_open(row + 1, col + 1)) moves |= GRID_MOVE_DOWN_RIGHT;
+
+    return moves;
+}
 
-void 
-gridCreate(u16 window_width, u16 window_height, u8 grid_rows, u8 grid_cols)
+// A wall changing at (row, col) only changes the moves of the 3 x 3 cells around it
+static void
+update_moves(u32 row, u32 col)
 {
-    g_grid_rows = grid_rows;
-    g_grid_cols = grid_cols;
+    if (g_grid.moves == NULL) return;
+
+    u32 first_row = row > 0 ? row - 1 : 0;
+    u32 first_col = col > 0 ? col - 1 : 0;
+    u32 last_row  = row + 1 < g_grid.rows ? row + 1 : row;
+    u32 last_col  = col + 1 < g_grid.cols ? col + 1 : col;
 
-    u32 available_window_width  = window_width - 2 * WINDOW_MARGIN;
-    u32 available_window_height = window_height - 2 * WINDOW_MARGIN;
+    for (u32 r = first_row; r <= last_row; ++r)
+    {
+        for (u32 c = first_col; c <= last_col; ++c) g_grid.moves[r * g_grid.cols + c] = cell_moves(r, c);
+    }
+}
 
-    u16 cell_width    = available_window_width / grid_cols;
-    u16 cell_height   = available_window_height / grid_rows;   
+static void
+rescan_max_weight(void)
+{
+    u64 cell_count = gridGetCellCount();
 
-    g_grid = daCreate(sizeof(Cell), grid_rows * grid_cols);
+    g_grid.max_weight = 1;
+    g_grid.max_count  = 0;
 
-    for (u64 row = 0; row < grid_rows; ++row)
+    for (u64 i = 0; i < cell_count; ++i)
     {
-        for (u64 col = 0; col < grid_cols; ++col)
+        if (g_grid.weight[i] > g_grid.max_weight)
         {
-            daPushBack(&g_grid, &(Cell){
-                .distance   = INT32_MAX,
-                .weight     = 1,
+            g_grid.max_weight = g_grid.weight[i];
+            g_grid.max_count  = 0;
+        }
 
-                .x_pos      = WINDOW_MARGIN + cell_width * col,
-                .y_pos      = WINDOW_MARGIN + cell_height * row,
-                .width      = cell_width,
-                .height     = cell_height,
+        if (g_grid.weight[i] == g_grid.max_weight) g_grid.max_count += 1;
+    }
+}
 
-                .parent     = NULL,
+// The search state needs no initial values thanks to the stamps, so the
+// allocations stay untouched until a search reaches them
+static void
+create(u32 grid_rows, u32 grid_cols, u32* weight, u64* wall, u32 max_weight)
+{
+    u64 cell_count = (u64)grid_rows * grid_cols;
+    u64 word_count = bit_words(cell_count);
+
+    g_grid = (Grid){
+        .rows       = grid_rows,
+        .cols       = grid_cols,
+        .start      = GRID_NO_CELL,
+        .goal       = GRID_NO_CELL,
+        .max_weight = max_weight,
+        .revision   = g_grid.revision + 1,
+        .connectivity = g_grid.connectivity,
+
+        .weight     = weight,
+        .wall       = wall,
+
+        .distance   = malloc(cell_count * sizeof(u32)),
+        .parent     = malloc(cell_count * sizeof(u32)),
+        .heuristic  = malloc(cell_count * sizeof(u32)),
+        .stamp      = calloc(cell_count, sizeof(u32)),
+        .epoch      = 0,
+        .visited    = calloc(word_count, sizeof(u64)),
+        .reached    = calloc(word_count, sizeof(u64))
+    };
+
+    gridReset();
+
+    LOG_DEBUG("Number of cells: %lu", cell_count);
+    LOG_DEBUG("Total memory for grid: %lu bytes", gridGetMemoryBytes());
+}
 
-                .color      = CELL_PATH_COLOR,
+void
+gridCreate(u32 grid_rows, u32 grid_cols)
+{
+    u64 cell_count = (u64)grid_rows * grid_cols;
 
-                .is_goal    = 0,
-                .is_start   = 0,
-                .is_visited = 0,
-                .is_wall    = 0,
+    u32* weight = malloc(cell_count * sizeof(u32));
+    for (u64 i = 0; i < cell_count; ++i) weight[i] = 1;
 
-                .heuristic  = 0,
+    create(grid_rows, grid_cols, weight, calloc(bit_words(cell_count), sizeof(u64)), 1);
+    g_grid.max_count = cell_count;
+}
 
-                .row        = row,
-                .col        = col
-            });
-        }
-    }
+void
+gridCreateMapped(u32 grid_rows, u32 grid_cols, u32* weight, u64* wall, u32 max_weight,
+                 void* mapping, u64 mapping_size)
+{
+    create(grid_rows, grid_cols, weight, wall, max_weight);
 
-    LOG_DEBUG("Size of cell: %lu bytes", sizeof(Cell));
-    LOG_DEBUG("Number of cells: %lu", grid_rows * grid_cols);
-    LOG_DEBUG("Total memory for grid: %lu bytes", grid_rows * grid_cols * sizeof(Cell));
+    g_grid.mapping      = mapping;
+    g_grid.mapping_size = mapping_size;
 }
 
-void 
+void
 gridDestroy(void)
 {
-    daDestroy(&g_grid);
+    if (g_grid.mapping != NULL)
+    {
+        munmap(g_grid.mapping, g_grid.mapping_size);
+    }
+    else
+    {
+        free(g_grid.weight);
+        free(g_grid.wall);
+    }
+
+    free(g_grid.distance);
+    free(g_grid.parent);
+    free(g_grid.heuristic);
+    free(g_grid.stamp);
+    free(g_grid.visited);
+    free(g_grid.reached);
+    free(g_grid.moves);
+
+    g_grid = (Grid){
+        .start          = GRID_NO_CELL,
+        .goal           = GRID_NO_CELL,
+        .revision       = g_grid.revision,
+        .connectivity   = g_grid.connectivity
+    };
 }
 
-static void 
-gridEdit(Color color, u8 is_start, u8 is_goal, u8 is_wall, u8 is_visited)
+void
+gridClear(void)
 {
-    for (u64 i = 0; i < daGetSize(&g_grid); ++i)
-    {
-        Cell* cell = (Cell*)daGet(&g_grid, i);
+    u64 cell_count = gridGetCellCount();
 
-        u16 left    = cell->x_pos;
-        u16 top     = cell->y_pos;
-        u16 right   = cell->x_pos + cell->width;
-        u16 bottom  = cell->y_pos + cell->height;
+    g_grid.start = GRID_NO_CELL;
+    g_grid.goal  = GRID_NO_CELL;
 
-        u32 mouse_x_pos = GetMouseX();
-        u32 mouse_y_pos = GetMouseY();
+    for (u64 i = 0; i < cell_count; ++i) g_grid.weight[i] = 1;
+    memset(g_grid.wall, 0, bit_words(cell_count) * sizeof(u64));
+    g_grid.max_weight = 1;
+    g_grid.max_count  = cell_count;
+    g_grid.revision  += 1;
 
-        if (left < mouse_x_pos && mouse_x_pos < right &&
-            top  < mouse_y_pos && mouse_y_pos < bottom)
-        {
-            cell->color         = color;
-            cell->is_start      = is_start;
-            cell->is_goal       = is_goal;
-            cell->is_wall       = is_wall;
-            cell->is_visited    = is_visited;
-
-            if (is_goal     == 1) g_goal    = cell;
-            if (is_start    == 1) g_start   = cell;
-        }
-    }
+    // Rebuilt by the next search
+    free(g_grid.moves);
+    g_grid.moves = NULL;
+
+    gridReset();
 }
 
-static void 
-gridWeight(i64 weight)
+void
+gridReset(void)
 {
-    for (u64 i = 0; i < daGetSize(&g_grid); ++i)
+    u64 cell_count = gridGetCellCount();
+
+    // Stamps only need clearing once every 2^32 searches
+    g_grid.epoch += 1;
+    if (g_grid.epoch == 0)
     {
-        Cell* cell = (Cell*)daGet(&g_grid, i);
+        memset(g_grid.stamp, 0, cell_count * sizeof(u32));
+        g_grid.epoch = 1;
+    }
 
-        u16 left    = cell->x_pos;
-        u16 top     = cell->y_pos;
-        u16 right   = cell->x_pos + cell->width;
-        u16 bottom  = cell->y_pos + cell->height;
+    // Still O(cells) at two bits per cell. The parallel searches claim cells
+    // with atomic word operations and the worker and view diff whole words,
+    // so both bitsets must really be zero rather than stale by stamp.
+    memset(g_grid.visited, 0, bit_words(cell_count) * sizeof(u64));
+    memset(g_grid.reached, 0, bit_words(cell_count) * sizeof(u64));
+}
 
-        u32 mouse_x_pos = GetMouseX();
-        u32 mouse_y_pos = GetMouseY();
+void
+gridBuildMoves(void)
+{
+    if (g_grid.moves != NULL) return;
 
-        if (left < mouse_x_pos && mouse_x_pos < right &&
-            top  < mouse_y_pos && mouse_y_pos < bottom)
-        {
-            if (cell->weight == 1 && weight < 0) return;
+    g_grid.moves = malloc(gridGetCellCount());
 
-            cell->weight = cell->weight + weight;
-            
-            LOG_DEBUG("Row: %d | Col: %d | Weight: %d", cell->row, cell->col, cell->weight);
-        }
+    for (u32 row = 0; row < g_grid.rows; ++row)
+    {
+        for (u32 col = 0; col < g_grid.cols; ++col) g_grid.moves[row * g_grid.cols + col] = cell_moves(row, col);
     }
 }
 
-static void gridClear(void)
+void
+gridTouchAll(void)
 {
-    g_start = NULL;
-    g_goal  = NULL;
+    u64 cell_count = gridGetCellCount();
 
-    for (u64 i = 0; i < daGetSize(&g_grid); ++i)
-    {
-        Cell* cell = (Cell*)daGet(&g_grid, i);
-
-        cell->distance   = INT32_MAX;
-        cell->weight     = 1;
-        cell->parent     = NULL;
-        cell->color      = CELL_PATH_COLOR;
-        cell->is_goal    = 0;
-        cell->is_start   = 0;
-        cell->is_visited = 0;
-        cell->is_wall    = 0;
-        cell->heuristic  = 0;
-    }
+    // GRID_INFINITY and GRID_NO_CELL are all ones
+    memset(g_grid.distance,  0xFF, cell_count * sizeof(u32));
+    memset(g_grid.parent,    0xFF, cell_count * sizeof(u32));
+    memset(g_grid.heuristic, 0,    cell_count * sizeof(u32));
+
+    for (u64 i = 0; i < cell_count; ++i) g_grid.stamp[i] = g_grid.epoch;
 }
 
-static void gridReset(void)
+void
+gridSetStart(u32 row, u32 col)
 {
-    for (u64 i = 0; i < daGetSize(&g_grid); ++i)
-    {
-        Cell* cell = (Cell*)daGet(&g_grid, i);
+    u32 cell = gridGetCell(row, col);
+
+    g_grid.start = cell;
 
-        cell->distance   = INT32_MAX;
-        cell->parent     = NULL;
-        cell->color      = cell->is_wall == 1 ? CELL_WALL_COLOR : CELL_PATH_COLOR;
-        cell->is_visited = 0;
-        cell->heuristic  = 0;
+    if (gridIsWall(&g_grid, cell) == 1)
+    {
+        gridBitClear(g_grid.wall, cell);
+        update_moves(row, col);
+        g_grid.revision += 1;
     }
 
-    g_start->color  = CELL_START_COLOR;
-    g_goal->color   = CELL_GOAL_COLOR;
+    if (g_grid.goal == cell) g_grid.goal = GRID_NO_CELL;
 }
 
-void 
-gridUpdate(void)
+void
+gridSetGoal(u32 row, u32 col)
 {
-    // Increase weight
-    if (IsKeyDown(KEY_LEFT_SHIFT) && IsKeyPressed(KEY_EQUAL))
-    {
-        LOG_DEBUG("SHIFT + =: Increase Weight");
-        gridWeight(1);
-        return;
-    }
+    u32 cell = gridGetCell(row, col);
 
-    // Decrease weight
-    if (IsKeyDown(KEY_LEFT_SHIFT) && IsKeyPressed(KEY_MINUS))
-    {
-        LOG_DEBUG("SHIFT + -: Decrease Weight");
-        gridWeight(-1);
-        return;
-    }
+    g_grid.goal = cell;
 
-    // Path
-    if ((IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT)) && IsMouseButtonDown(MOUSE_LEFT_BUTTON))
-    {
-        LOG_DEBUG("SHIFT + LMB: Path");
-        gridEdit(CELL_PATH_COLOR, 0, 0, 0, 0);
-        return;
-    }
-    
-    // Wall
-    if (!IsKeyDown(KEY_LEFT_SHIFT) && !IsKeyDown(KEY_RIGHT_SHIFT) && IsMouseButtonDown(MOUSE_LEFT_BUTTON))
+    if (gridIsWall(&g_grid, cell) == 1)
     {
-        LOG_DEBUG("LMB: Wall");
-        gridEdit(CELL_WALL_COLOR, 0, 0, 1, 0);
-        return;
+        gridBitClear(g_grid.wall, cell);
+        update_moves(row, col);
+        g_grid.revision += 1;
     }
 
-    // Start
-    if (!IsKeyDown(KEY_LEFT_SHIFT) && !IsKeyDown(KEY_RIGHT_SHIFT) && IsMouseButtonPressed(MOUSE_RIGHT_BUTTON))
-    {
-        LOG_DEBUG("RMB: Start");
-        if (g_start != NULL) { g_start->color = CELL_PATH_COLOR; g_start->is_start = 0; }
-        gridEdit(CELL_START_COLOR, 1, 0, 0, 0);
-        return;
-    }
+    if (g_grid.start == cell) g_grid.start = GRID_NO_CELL;
+}
 
-    // Goal
-    if ((IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT)) && IsMouseButtonPressed(MOUSE_RIGHT_BUTTON))
-    {
-        LOG_DEBUG("SHIFT + RMB: Goal");
-        if (g_goal != NULL) { g_goal->color = CELL_PATH_COLOR; g_goal->is_goal = 0; }
-        gridEdit(CELL_GOAL_COLOR, 0, 1, 0, 0);
-        return;
-    }
+void
+gridSetWall(u32 row, u32 col, b8 is_wall)
+{
+    u32 cell = gridGetCell(row, col);
 
-    // Clear 
-    if ((IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT)) && IsKeyPressed(KEY_C))
-    {
-        LOG_DEBUG("SHIFT + C: Clear Grid");
-        gridClear();
-        return;
-    }
+    if (cell == g_grid.start) g_grid.start = GRID_NO_CELL;
+    if (cell == g_grid.goal)  g_grid.goal  = GRID_NO_CELL;
 
-    // Reset
-    if ((IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT)) && IsKeyPressed(KEY_R))
-    {
-        LOG_DEBUG("SHIFT + R: Reset Grid");
-        gridReset();
-        return;
-    }
+    if (gridIsWall(&g_grid, cell) == (is_wall != 0)) return;
 
-    // Breadth First Search
-    if ((IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT)) && IsKeyPressed(KEY_ONE) && g_start != NULL && g_goal != NULL)
-    {
-        LOG_DEBUG("SHIFT + 1: Breadth First Search");
-        gridReset();
-        g_active_algo = ALGO_BFS;
-        bfsInit(daGetSize(&g_grid));       
-    }
+    if (is_wall == 1)   gridBitSet(g_grid.wall, cell);
+    else                gridBitClear(g_grid.wall, cell);
 
-    if (g_active_algo == ALGO_BFS && !bfsShouldStop()) bfsStep();
+    update_moves(row, col);
+    g_grid.revision += 1;
+}
 
-    // Depth First Search
-    if ((IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT)) && IsKeyPressed(KEY_TWO) && g_start != NULL && g_goal != NULL)
-    {
-        LOG_DEBUG("SHIFT + 2: Depth First Search");
-        gridReset();
-        g_active_algo = ALGO_DFS;
-        dfsInit(daGetSize(&g_grid));       
-    }
+void
+gridSetWeight(u32 row, u32 col, u32 weight)
+{
+    u32 cell = gridGetCell(row, col);
 
-    if (g_active_algo == ALGO_DFS && !dfsShouldStop()) dfsStep();
+    if (weight == 0)                weight = 1;
+    if (weight > GRID_MAX_WEIGHT)   weight = GRID_MAX_WEIGHT;
+    if (g_grid.weight[cell] == weight) return;
 
-    // Dijkstra
-    if ((IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT)) && IsKeyPressed(KEY_THREE) && g_start != NULL && g_goal != NULL)
-    {
-        LOG_DEBUG("SHIFT + 3: Dijkstra");
-        gridReset();
-        g_active_algo = ALGO_DIJKSTRA;
-        dijkstraInit(daGetSize(&g_grid));       
-    }
+    u32 previous = g_grid.weight[cell];
 
-    if (g_active_algo == ALGO_DIJKSTRA && !dijkstraShouldStop()) dijkstraStep();
+    g_grid.weight[cell]  = weight;
+    g_grid.revision     += 1;
 
-    // A*
-    if ((IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT)) && IsKeyPressed(KEY_FOUR) && g_start != NULL && g_goal != NULL)
+    if (weight > g_grid.max_weight)
+    {
+        g_grid.max_weight = weight;
+        g_grid.max_count  = 1;
+    }
+    else if (weight == g_grid.max_weight)
     {
-        LOG_DEBUG("SHIFT + 4: A*");
-        gridReset();
-        g_active_algo = ALGO_ASTAR;
-        aStarInit(daGetSize(&g_grid));       
+        if (g_grid.max_count > 0) g_grid.max_count += 1;
     }
+    else if (previous == g_grid.max_weight)
+    {
+        // The bound picks the queue, the delta-stepping buckets and whether JPS
+        // may run, so it comes back down once no cell holds it anymore
+        if (g_grid.max_count > 1)   g_grid.max_count -= 1;
+        else                        rescan_max_weight();
+    }
+}
 
-    if (g_active_algo == ALGO_ASTAR && !aStarShouldStop()) aStarStep();
+Grid*
+gridGet(void)
+{
+    return &g_grid;
 }
 
-void 
-gridDraw(void)
+void
+gridSetConnectivity(u32 connectivity)
 {
-    for (u64 i = 0; i < daGetSize(&g_grid); ++i)
+    if (connectivity != GRID_CONNECT_4 && connectivity != GRID_CONNECT_8)
     {
-        Cell* cell = (Cell*)daGet(&g_grid, i);
-        DrawRectangle(cell->x_pos, cell->y_pos, cell->width - 1, cell->height - 1, cell->color);
+        LOG_ERROR("Connectivity must be 4 or 8, not %u", connectivity);
+        return;
     }
+
+    g_grid.connectivity = connectivity;
 }
 
-void*  
+u32
 gridGetStart(void)
 {
-    return &g_start;
+    return g_grid.start;
 }
 
-void*   
+u32
 gridGetGoal(void)
 {
-    return &g_goal;
+    return g_grid.goal;
 }
 
-void*   
-gridGetCell(u8 row, u8 col)
+u32
+gridGetCell(u32 row, u32 col)
 {
-    return (Cell*)daGet(&g_grid, col + g_grid_cols * row);
+    return col + g_grid.cols * row;
 }
 
-u8      
+u32
 gridGetRows(void)
 {
-    return g_grid_rows;
+    return g_grid.rows;
 }
 
-u8      
+u32
 gridGetCols(void)
 {
-    return g_grid_cols;
+    return g_grid.cols;
+}
+
+u64
+gridGetCellCount(void)
+{
+    return (u64)g_grid.rows * g_grid.cols;
+}
+
+u64
+gridGetMemoryBytes(void)
+{
+    u64 cell_count = gridGetCellCount();
+
+    // weight, distance, parent, heuristic and stamp + the wall, visited and reached bitsets + the moves
+    u64 bytes = cell_count * 5 * sizeof(u32) + 3 * bit_words(cell_count) * sizeof(u64);
+    if (g_grid.moves != NULL) bytes += cell_count;
+
+    return bytes;
 }
@@ -0,0 +1,1048 @@
+#include "grid_view.h"
+
+#include "logger.h"
+
+#include "grid.h"
+#include "grid_neighbors.h"
+#include "search.h"
+#include "search_worker.h"
+#include "animate.h"
+#include "map_io.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define WINDOW_MARGIN 100
+
+// Stats overlay: three lines in the top margin, four with smoothing on,
+// right of DrawFPS(0, 0)
+#define STATS_X_POS         WINDOW_MARGIN
+#define STATS_FONT_SIZE     20
+#define STATS_LINE_HEIGHT   24
+#define STATS_COLOR         RAYWHITE
+
+#define WAYPOINT_LINE_WIDTH 2.0f
+
+// Shift + S writes the grid here, it opens again with ./pathfinder grid.pfmap
+#define GRID_SAVE_PATH "grid.pfmap"
+
+typedef struct CellRect
+{
+    u32     x_pos;
+    u32     y_pos;
+    u32     width;
+    u32     height;
+} CellRect;
+
+static u32 g_view_width  = 0;
+static u32 g_view_height = 0;
+
+// Shift + 1, 3 and 4 run the bidirectional variants while this is set
+static b8  g_view_bidirectional = 0;
+
+// Shift + P: string pull the path found and draw its waypoints over it
+static b8         g_view_smooth    = 0;
+static SearchPath g_view_waypoints = {0};
+
+// How much of the search runs per frame
+typedef enum {
+    STEP_SINGLE     = 0,    // one expansion, to follow the algorithm
+    STEP_BUDGET     = 1,    // as many expansions as fit in the budget
+    STEP_INSTANT    = 2,    // the whole search, only the path is animated
+    STEP_MODE_COUNT
+} StepMode;
+
+#define STEP_BUDGET_DEFAULT_MS  4
+#define STEP_BUDGET_MAX_MS      64
+
+// Events applied per frame at most, the rest wait for the next one
+#define VIEW_EVENTS_PER_FRAME   (1u << 18)
+
+static const char* g_step_mode_names[STEP_MODE_COUNT] = {
+    [STEP_SINGLE]   = "single step",
+    [STEP_BUDGET]   = "time budget",
+    [STEP_INSTANT]  = "instant"
+};
+
+static StepMode   g_view_step_mode = STEP_SINGLE;
+static u32        g_view_budget_ms = STEP_BUDGET_DEFAULT_MS;
+static SearchAlgo g_view_algo      = ALGO_NONE;
+
+// Counters of the search being shown, as the worker last published them
+static SearchResult g_view_result  = {0};
+
+// Where the search being shown stands, as far as the events drained so far tell
+typedef enum {
+    VIEW_SEARCH_RUNNING     = 0,
+    VIEW_SEARCH_FOUND       = 1,
+    VIEW_SEARCH_NO_PATH     = 2,
+    VIEW_SEARCH_CANCELLED   = 3,
+    VIEW_SEARCH_STATE_COUNT
+} ViewSearchState;
+
+static const char* g_view_search_state_names[VIEW_SEARCH_STATE_COUNT] = {
+    [VIEW_SEARCH_RUNNING]   = "running",
+    [VIEW_SEARCH_FOUND]     = "found",
+    [VIEW_SEARCH_NO_PATH]   = "no path",
+    [VIEW_SEARCH_CANCELLED] = "cancelled"
+};
+
+static ViewSearchState g_view_search_state = VIEW_SEARCH_RUNNING;
+
+// The search runs on the worker thread and owns the grid's search state, so
+// the cells are drawn from these, which only the worker's events change
+static u64* g_view_visited    = NULL;
+static u64* g_view_frontier   = NULL;
+static u64  g_view_word_count = 0;
+
+// Last cell of the wall stroke being dragged, the next frame draws a line
+// from it so fast drags leave no gaps
+static u32 g_view_stroke_cell = GRID_NO_CELL;
+
+// Corners of the rectangle being dragged with Ctrl + LMB
+static u32 g_view_rect_anchor = GRID_NO_CELL;
+static u32 g_view_rect_corner = GRID_NO_CELL;
+
+// The grid is drawn as one texture with a texel per cell, scaled over the
+// view. Each frame only the cells whose wall, visited, frontier or path bit
+// differs from the copy the texture was built from are recolored and
+// uploaded, so the edit code needs no hooks and a frame costs one comparison
+// per 64 cells plus the cells that changed.
+typedef struct GridTexture
+{
+    Texture2D   texture;
+    Color*      pixels;         // what the texture holds, one color per cell
+    u32         rows;
+    u32         cols;
+    u64         word_count;
+
+    // Bits and cells the pixels were last colored from
+    u64*        wall;
+    u64*        visited;
+    u64*        frontier;
+    u64*        path;
+    u32         start;
+    u32         goal;
+} GridTexture;
+
+static GridTexture g_view_texture = {0};
+
+// Sizes the view bits to the grid and clears them
+static void
+view_clear_search(void)
+{
+    u64 word_count = (gridGetCellCount() + 63) / 64;
+
+    if (word_count != g_view_word_count)
+    {
+        free(g_view_visited);
+        free(g_view_frontier);
+
+        g_view_visited    = malloc(word_count * sizeof(u64));
+        g_view_frontier   = malloc(word_count * sizeof(u64));
+        g_view_word_count = word_count;
+    }
+
+    memset(g_view_visited,  0, word_count * sizeof(u64));
+    memset(g_view_frontier, 0, word_count * sizeof(u64));
+}
+
+// Waypoints of the path shown, while smoothing is on
+static void
+view_smooth_path(void)
+{
+    const SearchPath* path = animateGetPath();
+
+    if (g_view_smooth == 0 || path->count == 0)
+    {
+        searchPathClear(&g_view_waypoints);
+        return;
+    }
+
+    searchPathSmooth(gridGet(), path, &g_view_waypoints);
+    LOG_INFO("Smoothed %u cells to %u waypoints, length %.1f instead of %.1f", path->count,
+             g_view_waypoints.count, searchPathLength(gridGet(), &g_view_waypoints), searchPathLength(gridGet(), path));
+}
+
+static void
+view_clear_path(void)
+{
+    animateClear();
+    searchPathClear(&g_view_waypoints);
+}
+
+void
+gridViewCreate(u16 window_width, u16 window_height)
+{
+    g_view_width  = window_width - 2 * WINDOW_MARGIN;
+    g_view_height = window_height - 2 * WINDOW_MARGIN;
+
+    view_clear_search();
+
+    searchWorkerCreate();
+    searchWorkerSetBudget(0);
+}
+
+// First pixel of a cell along one axis: the pixels whose center falls in
+// the cell once count cells are stretched over extent pixels, the same ones
+// nearest sampling of the grid texture paints with it
+static u32
+view_offset(u32 index, u32 extent, u32 count)
+{
+    u64 scaled = 2 * (u64)index * extent;
+    if (scaled <= count) return 0;
+
+    return (scaled - count + 2 * (u64)count - 1) / (2 * (u64)count);
+}
+
+// Cells are spread over the view with integer math, so grids with more
+// cells than pixels still cover the whole area
+static CellRect
+cell_rect(u32 row, u32 col)
+{
+    u32 rows = gridGetRows();
+    u32 cols = gridGetCols();
+
+    u32 left    = view_offset(col,     g_view_width,  cols);
+    u32 right   = view_offset(col + 1, g_view_width,  cols);
+    u32 top     = view_offset(row,     g_view_height, rows);
+    u32 bottom  = view_offset(row + 1, g_view_height, rows);
+
+    return (CellRect){
+        .x_pos  = WINDOW_MARGIN + left,
+        .y_pos  = WINDOW_MARGIN + top,
+        .width  = right - left,
+        .height = bottom - top
+    };
+}
+
+static Color
+cell_color(const Grid* grid, u32 cell)
+{
+    if (animateIsOnPath(cell)              == 1) return CELL_SOLUTION_COLOR;
+    if (cell == grid->start)                     return CELL_START_COLOR;
+    if (cell == grid->goal)                      return CELL_GOAL_COLOR;
+    if (gridIsWall(grid, cell)             == 1) return CELL_WALL_COLOR;
+    if (gridBitTest(g_view_visited, cell)  == 1) return CELL_VISITED_COLOR;
+    if (gridBitTest(g_view_frontier, cell) == 1) return CELL_FRONTIER_COLOR;
+
+    return CELL_PATH_COLOR;
+}
+
+// Inverse of view_offset(): the cell whose texel the pixel center samples
+static u32
+view_index(u32 offset, u32 extent, u32 count)
+{
+    u32 index = (2 * (u64)offset + 1) * count / (2 * (u64)extent);
+
+    return index < count ? index : count - 1;
+}
+
+static u32
+cell_under_mouse(void)
+{
+    i32 mouse_x_pos = GetMouseX() - WINDOW_MARGIN;
+    i32 mouse_y_pos = GetMouseY() - WINDOW_MARGIN;
+
+    if (mouse_x_pos < 0 || (u32)mouse_x_pos >= g_view_width)  return GRID_NO_CELL;
+    if (mouse_y_pos < 0 || (u32)mouse_y_pos >= g_view_height) return GRID_NO_CELL;
+
+    u32 row = view_index(mouse_y_pos, g_view_height, gridGetRows());
+    u32 col = view_index(mouse_x_pos, g_view_width,  gridGetCols());
+
+    return gridGetCell(row, col);
+}
+
+// The worker reads the map while it steps, so edits are made between
+// searchWorkerPause() and this. A replanning LPA* draws a new path.
+static void
+edit_end(b8 replans)
+{
+    if (replans == 1)
+    {
+        view_clear_path();
+        g_view_search_state = VIEW_SEARCH_RUNNING;
+    }
+
+    searchWorkerResume(replans);
+}
+
+// Applies one edit, returns 1 if the running search replans because of it
+static b8
+edit_cell(u32 cell, u8 is_start, u8 is_goal, u8 is_wall)
+{
+    Grid* grid = gridGet();
+    u32   row  = cell / grid->cols;
+    u32   col  = cell % grid->cols;
+
+    b8  was_wall = gridIsWall(grid, cell);
+    u32 start    = grid->start;
+    u32 goal     = grid->goal;
+
+    if      (is_start == 1) gridSetStart(row, col);
+    else if (is_goal  == 1) gridSetGoal(row, col);
+    else                    gridSetWall(row, col, is_wall);
+
+    // Dragging over cells that already match would replan every frame
+    if (gridIsWall(grid, cell) == was_wall && grid->start == start && grid->goal == goal) return 0;
+
+    return searchNotifyCellChanged(cell);
+}
+
+// Walls or clears every cell on a 4-connected line between two cells, so a
+// wall stroke stays closed even where it runs diagonally
+static b8
+edit_line(u32 from, u32 to, u8 is_wall)
+{
+    u32 cols = gridGetCols();
+
+    i32 row      = from / cols;
+    i32 col      = from % cols;
+    i32 rows_to  = (i32)(to / cols) - row;
+    i32 cols_to  = (i32)(to % cols) - col;
+    i32 row_step = rows_to < 0 ? -1 : 1;
+    i32 col_step = cols_to < 0 ? -1 : 1;
+    u64 dy       = abs(rows_to);
+    u64 dx       = abs(cols_to);
+
+    b8 replans = edit_cell(from, 0, 0, is_wall);
+
+    // Step along the axis whose next cell center lies closer to the line
+    for (u64 x = 0, y = 0; x < dx || y < dy;)
+    {
+        if ((2 * x + 1) * dy < (2 * y + 1) * dx)    { col += col_step; ++x; }
+        else                                        { row += row_step; ++y; }
+
+        replans |= edit_cell(gridGetCell(row, col), 0, 0, is_wall);
+    }
+
+    return replans;
+}
+
+static void
+gridEdit(u8 is_start, u8 is_goal, u8 is_wall)
+{
+    u32 cell = cell_under_mouse();
+    if (cell == GRID_NO_CELL)
+    {
+        g_view_stroke_cell = GRID_NO_CELL;
+        return;
+    }
+
+    searchWorkerPause();
+
+    b8 replans;
+    if (is_start == 1 || is_goal == 1)
+    {
+        replans = edit_cell(cell, is_start, is_goal, is_wall);
+    }
+    else
+    {
+        u32 from = g_view_stroke_cell != GRID_NO_CELL ? g_view_stroke_cell : cell;
+
+        replans            = edit_line(from, cell, is_wall);
+        g_view_stroke_cell = cell;
+    }
+
+    edit_end(replans);
+}
+
+// Rows and columns of the rectangle spanned by two cells, bounds included
+static void
+rect_bounds(u32 anchor, u32 corner, u32* top, u32* bottom, u32* left, u32* right)
+{
+    u32 cols = gridGetCols();
+
+    u32 anchor_row = anchor / cols;
+    u32 anchor_col = anchor % cols;
+    u32 corner_row = corner / cols;
+    u32 corner_col = corner % cols;
+
+    *top    = anchor_row < corner_row ? anchor_row : corner_row;
+    *bottom = anchor_row < corner_row ? corner_row : anchor_row;
+    *left   = anchor_col < corner_col ? anchor_col : corner_col;
+    *right  = anchor_col < corner_col ? corner_col : anchor_col;
+}
+
+// Walls or clears the rectangle spanned by two cells, start and goal are kept
+static void
+gridFillRect(u32 anchor, u32 corner, u8 is_wall)
+{
+    Grid* grid = gridGet();
+
+    u32 top, bottom, left, right;
+    rect_bounds(anchor, corner, &top, &bottom, &left, &right);
+
+    searchWorkerPause();
+
+    b8 replans = 0;
+    for (u32 row = top; row <= bottom; ++row)
+    {
+        for (u32 col = left; col <= right; ++col)
+        {
+            u32 cell = gridGetCell(row, col);
+            if (cell == grid->start || cell == grid->goal) continue;
+
+            replans |= edit_cell(cell, 0, 0, is_wall);
+        }
+    }
+
+    edit_end(replans);
+
+    LOG_DEBUG("Filled rows %u-%u, cols %u-%u", top, bottom, left, right);
+}
+
+// Flips the region of open cells (or of walls) connected to the cell under
+// the mouse, stopping at the start and goal
+static void
+gridFloodFill(void)
+{
+    u32 cell = cell_under_mouse();
+
+    Grid* grid = gridGet();
+    if (cell == GRID_NO_CELL || cell == grid->start || cell == grid->goal) return;
+
+    searchWorkerPause();
+
+    b8   is_wall = !gridIsWall(grid, cell);
+    u32* queue   = malloc(gridGetCellCount() * sizeof(u32));
+    u64  head    = 0;
+    u64  tail    = 0;
+    b8   replans = edit_cell(cell, 0, 0, is_wall);
+
+    // Cells are flipped as they are queued, so each one is queued once
+    queue[tail++] = cell;
+    while (head < tail)
+    {
+        u32 current = queue[head++];
+
+        // Clearing walls crosses them, so the moves mask of open cells won't do
+        u32 neighbors[4];
+        u32 count = gridAdjacentCells(grid, current, neighbors);
+
+        for (u32 i = 0; i < count; ++i)
+        {
+            u32 neighbor = neighbors[i];
+            if (gridIsWall(grid, neighbor) == is_wall || neighbor == grid->start || neighbor == grid->goal) continue;
+
+            replans       |= edit_cell(neighbor, 0, 0, is_wall);
+            queue[tail++]  = neighbor;
+        }
+    }
+
+    free(queue);
+
+    edit_end(replans);
+
+    LOG_DEBUG("Flood fill: %lu cells %s", tail, is_wall ? "walled" : "cleared");
+}
+
+static void
+gridWeight(i64 weight)
+{
+    u32 cell = cell_under_mouse();
+    if (cell == GRID_NO_CELL) return;
+
+    Grid* grid = gridGet();
+    u32   row  = cell / grid->cols;
+    u32   col  = cell % grid->cols;
+
+    if (grid->weight[cell] == 1 && weight < 0) return;
+
+    searchWorkerPause();
+    gridSetWeight(row, col, grid->weight[cell] + weight);
+    edit_end(searchNotifyCellChanged(cell));
+}
+
+static void
+gridRun(SearchAlgo algo)
+{
+    if (gridGetStart() == GRID_NO_CELL || gridGetGoal() == GRID_NO_CELL) return;
+
+    // The cells of the last search stay until the worker's reset event
+    view_clear_path();
+    searchWorkerStart(algo);
+
+    g_view_algo         = algo;
+    g_view_result       = (SearchResult){0};
+    g_view_search_state = VIEW_SEARCH_RUNNING;
+}
+
+// Cancels the search and forgets what it showed, so the grid's search state
+// can be reset. Call searchWorkerResume() once done.
+static void
+view_stop_search(void)
+{
+    searchWorkerCancel();
+    searchWorkerPause();
+
+    // Events of the cancelled search would draw its cells again
+    SearchEvent event;
+    while (searchWorkerPollEvent(&event) == 1) {}
+
+    view_clear_search();
+    view_clear_path();
+}
+
+static void
+view_apply_event(SearchEvent event)
+{
+    u32 cell = event.cell;
+
+    switch (event.kind)
+    {
+        case SEARCH_EVENT_RESET:
+            // Path cells of the last search may have arrived after gridRun() cleared them
+            view_clear_search();
+            view_clear_path();
+            g_view_search_state = VIEW_SEARCH_RUNNING;
+            break;
+
+        case SEARCH_EVENT_FRONTIER:
+            gridBitSet(g_view_frontier, cell);
+            gridBitClear(g_view_visited, cell);
+            break;
+
+        case SEARCH_EVENT_VISIT:
+            gridBitSet(g_view_visited, cell);
+            gridBitClear(g_view_frontier, cell);
+            break;
+
+        case SEARCH_EVENT_CLEAR:
+            gridBitClear(g_view_visited, cell);
+            gridBitClear(g_view_frontier, cell);
+            break;
+
+        case SEARCH_EVENT_PATH:
+            animateAddCell(cell);
+            break;
+
+        case SEARCH_EVENT_DONE:
+            g_view_search_state = cell != GRID_NO_CELL ? VIEW_SEARCH_FOUND : VIEW_SEARCH_NO_PATH;
+            if (cell != GRID_NO_CELL) animateStart();
+            view_smooth_path();
+            break;
+
+        case SEARCH_EVENT_CANCELLED:
+            g_view_search_state = VIEW_SEARCH_CANCELLED;
+            LOG_INFO("%s: cancelled", searchAlgoName(g_view_algo));
+            break;
+
+        default:
+            break;
+    }
+}
+
+// Applies what the worker published since the last frame, up to
+// VIEW_EVENTS_PER_FRAME events so a burst never drops a frame
+static void
+view_drain_events(void)
+{
+    SearchEvent event;
+    for (u32 i = 0; i < VIEW_EVENTS_PER_FRAME && searchWorkerPollEvent(&event) == 1; ++i)
+    {
+        view_apply_event(event);
+
+        if (event.kind == SEARCH_EVENT_DONE)
+        {
+            // Solver time only, frames spent drawing between steps are not counted
+            g_view_result = searchWorkerGetResult();
+            LOG_INFO("%s: %lu cells expanded in %.3f ms", searchAlgoName(g_view_algo),
+                     g_view_result.stats.expanded, g_view_result.elapsed_ns / 1e6);
+        }
+    }
+}
+
+static void
+view_apply_budget(void)
+{
+    switch (g_view_step_mode)
+    {
+        case STEP_SINGLE:   searchWorkerSetBudget(0);                                   break;
+        case STEP_BUDGET:   searchWorkerSetBudget((u64)g_view_budget_ms * 1000000);     break;
+        case STEP_INSTANT:  searchWorkerSetBudget(SEARCH_BUDGET_UNLIMITED);             break;
+        default:                                                                        break;
+    }
+}
+
+void
+gridUpdate(void)
+{
+    b8 shift = IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT);
+    b8 ctrl  = IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL);
+
+    if (!IsMouseButtonDown(MOUSE_LEFT_BUTTON)) g_view_stroke_cell = GRID_NO_CELL;
+
+    // Rectangle: anchored on press, filled on release
+    if (ctrl && IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
+    {
+        g_view_rect_anchor = cell_under_mouse();
+        g_view_rect_corner = g_view_rect_anchor;
+        return;
+    }
+
+    if (g_view_rect_anchor != GRID_NO_CELL)
+    {
+        u32 cell = cell_under_mouse();
+        if (cell != GRID_NO_CELL) g_view_rect_corner = cell;
+
+        if (IsMouseButtonReleased(MOUSE_LEFT_BUTTON))
+        {
+            LOG_DEBUG("%sCTRL + LMB: %s rectangle", shift ? "SHIFT + " : "", shift ? "Clear" : "Wall");
+            gridFillRect(g_view_rect_anchor, g_view_rect_corner, !shift);
+            g_view_rect_anchor = GRID_NO_CELL;
+        }
+        return;
+    }
+
+    // Ctrl + LMB only drags rectangles, also when pressed outside the grid
+    if (ctrl && IsMouseButtonDown(MOUSE_LEFT_BUTTON)) return;
+
+    // Save
+    if (shift && IsKeyPressed(KEY_S))
+    {
+        LOG_DEBUG("SHIFT + S: Save Grid");
+        if (mapSaveAny(GRID_SAVE_PATH) == 1) LOG_INFO("Grid saved to %s", GRID_SAVE_PATH);
+        return;
+    }
+
+    // Flood fill
+    if (shift && IsKeyPressed(KEY_F))
+    {
+        LOG_DEBUG("SHIFT + F: Flood Fill");
+        gridFloodFill();
+        return;
+    }
+
+    // Increase weight
+    if (IsKeyDown(KEY_LEFT_SHIFT) && IsKeyPressed(KEY_EQUAL))
+    {
+        LOG_DEBUG("SHIFT + =: Increase Weight");
+        gridWeight(1);
+        return;
+    }
+
+    // Decrease weight
+    if (IsKeyDown(KEY_LEFT_SHIFT) && IsKeyPressed(KEY_MINUS))
+    {
+        LOG_DEBUG("SHIFT + -: Decrease Weight");
+        gridWeight(-1);
+        return;
+    }
+
+    // Path
+    if (shift && IsMouseButtonDown(MOUSE_LEFT_BUTTON))
+    {
+        LOG_DEBUG("SHIFT + LMB: Path");
+        gridEdit(0, 0, 0);
+        return;
+    }
+
+    // Wall
+    if (!shift && IsMouseButtonDown(MOUSE_LEFT_BUTTON))
+    {
+        LOG_DEBUG("LMB: Wall");
+        gridEdit(0, 0, 1);
+        return;
+    }
+
+    // Start
+    if (!shift && IsMouseButtonPressed(MOUSE_RIGHT_BUTTON))
+    {
+        LOG_DEBUG("RMB: Start");
+        gridEdit(1, 0, 0);
+        return;
+    }
+
+    // Goal
+    if (shift && IsMouseButtonPressed(MOUSE_RIGHT_BUTTON))
+    {
+        LOG_DEBUG("SHIFT + RMB: Goal");
+        gridEdit(0, 1, 0);
+        return;
+    }
+
+    // Clear
+    if (shift && IsKeyPressed(KEY_C))
+    {
+        LOG_DEBUG("SHIFT + C: Clear Grid");
+        view_stop_search();
+        gridClear();
+        searchWorkerResume(0);
+        return;
+    }
+
+    // Reset
+    if (shift && IsKeyPressed(KEY_R))
+    {
+        LOG_DEBUG("SHIFT + R: Reset Grid");
+        view_stop_search();
+        gridReset();
+        searchWorkerResume(0);
+        return;
+    }
+
+    // Cancel, what the search found so far stays on screen
+    if (shift && IsKeyPressed(KEY_X))
+    {
+        LOG_DEBUG("SHIFT + X: Cancel Search");
+        searchWorkerCancel();
+        return;
+    }
+
+    // Step mode
+    if (shift && IsKeyPressed(KEY_T))
+    {
+        g_view_step_mode = (g_view_step_mode + 1) % STEP_MODE_COUNT;
+        view_apply_budget();
+        LOG_INFO("Step mode: %s", g_step_mode_names[g_view_step_mode]);
+    }
+
+    // Time budget per frame
+    if (shift && IsKeyPressed(KEY_UP) && g_view_budget_ms < STEP_BUDGET_MAX_MS)
+    {
+        g_view_budget_ms *= 2;
+        view_apply_budget();
+        LOG_INFO("Step budget: %u ms per frame", g_view_budget_ms);
+    }
+
+    if (shift && IsKeyPressed(KEY_DOWN) && g_view_budget_ms > 1)
+    {
+        g_view_budget_ms /= 2;
+        view_apply_budget();
+        LOG_INFO("Step budget: %u ms per frame", g_view_budget_ms);
+    }
+
+    // Bidirectional mode
+    if (shift && IsKeyPressed(KEY_B))
+    {
+        g_view_bidirectional = !g_view_bidirectional;
+        LOG_DEBUG("SHIFT + B: Bidirectional search %s", g_view_bidirectional ? "on" : "off");
+    }
+
+    // Any-angle waypoints of the path
+    if (shift && IsKeyPressed(KEY_P))
+    {
+        g_view_smooth = !g_view_smooth;
+        LOG_DEBUG("SHIFT + P: Path smoothing %s", g_view_smooth ? "on" : "off");
+        view_smooth_path();
+    }
+
+    // Diagonal moves, from the next search on
+    if (shift && IsKeyPressed(KEY_D))
+    {
+        Grid* grid = gridGet();
+        searchWorkerPause();
+        gridSetConnectivity(grid->connectivity == GRID_CONNECT_8 ? GRID_CONNECT_4 : GRID_CONNECT_8);
+        searchWorkerResume(0);
+        LOG_INFO("Movement: %u-connected", grid->connectivity);
+    }
+
+    // Breadth First Search
+    if (shift && IsKeyPressed(KEY_ONE))
+    {
+        LOG_DEBUG("SHIFT + 1: Breadth First Search");
+        gridRun(g_view_bidirectional ? ALGO_BFS_BIDIR : ALGO_BFS);
+    }
+
+    // Depth First Search
+    if (shift && IsKeyPressed(KEY_TWO))
+    {
+        LOG_DEBUG("SHIFT + 2: Depth First Search");
+        gridRun(ALGO_DFS);
+    }
+
+    // Dijkstra
+    if (shift && IsKeyPressed(KEY_THREE))
+    {
+        LOG_DEBUG("SHIFT + 3: Dijkstra");
+        gridRun(g_view_bidirectional ? ALGO_DIJKSTRA_BIDIR : ALGO_DIJKSTRA);
+    }
+
+    // A*
+    if (shift && IsKeyPressed(KEY_FOUR))
+    {
+        LOG_DEBUG("SHIFT + 4: A*");
+        gridRun(g_view_bidirectional ? ALGO_ASTAR_BIDIR : ALGO_ASTAR);
+    }
+
+    // Jump Point Search
+    if (shift && IsKeyPressed(KEY_FIVE))
+    {
+        LOG_DEBUG("SHIFT + 5: Jump Point Search");
+        gridRun(ALGO_JPS);
+    }
+
+    // Jump Point Search with precomputed jumps
+    if (shift && IsKeyPressed(KEY_SIX))
+    {
+        LOG_DEBUG("SHIFT + 6: JPS+");
+        gridRun(ALGO_JPS_PLUS);
+    }
+
+    // Lifelong Planning A*
+    if (shift && IsKeyPressed(KEY_SEVEN))
+    {
+        LOG_DEBUG("SHIFT + 7: LPA*");
+        gridRun(ALGO_LPA_STAR);
+    }
+
+    // Hierarchical A* over 16 x 16 clusters
+    if (shift && IsKeyPressed(KEY_EIGHT))
+    {
+        LOG_DEBUG("SHIFT + 8: HPA*");
+        gridRun(ALGO_HPA);
+    }
+
+    // Level-synchronous BFS on every core, one frontier level per step
+    if (shift && IsKeyPressed(KEY_NINE))
+    {
+        LOG_DEBUG("SHIFT + 9: Parallel BFS");
+        gridRun(ALGO_BFS_PARALLEL);
+    }
+
+    // Delta-stepping on every core, one distance bucket per step
+    if (shift && IsKeyPressed(KEY_ZERO))
+    {
+        LOG_DEBUG("SHIFT + 0: Delta-stepping");
+        gridRun(ALGO_DELTA_STEPPING);
+    }
+
+    // A* bounded by landmark tables, built by the first run on a map
+    if (shift && IsKeyPressed(KEY_L))
+    {
+        LOG_DEBUG("SHIFT + L: A* with landmarks");
+        gridRun(ALGO_ASTAR_ALT);
+    }
+
+    searchWorkerGrant();
+    view_drain_events();
+
+    // The counters keep up with a running search between its events
+    if (g_view_search_state == VIEW_SEARCH_RUNNING) g_view_result = searchWorkerGetResult();
+}
+
+void
+gridDrawStats(void)
+{
+    if (g_view_algo == ALGO_NONE) return;
+
+    const SearchResult* result = &g_view_result;
+    const char*         state  = g_view_search_state_names[g_view_search_state];
+
+    DrawText(TextFormat("%s: %s, length %u, cost %lu", searchAlgoName(g_view_algo), state,
+                        result->path_length, result->path_cost),
+             STATS_X_POS, 0, STATS_FONT_SIZE, STATS_COLOR);
+    DrawText(TextFormat("expanded %lu, pushes %lu, stale pops %lu, peak frontier %lu", result->stats.expanded,
+                        result->stats.pushes, result->stats.stale_pops, result->stats.peak_frontier),
+             STATS_X_POS, STATS_LINE_HEIGHT, STATS_FONT_SIZE, STATS_COLOR);
+    DrawText(TextFormat("init %.3f ms, search %.3f ms, path %.3f ms", result->init_ns / 1e6,
+                        result->search_ns / 1e6, result->path_ns / 1e6),
+             STATS_X_POS, 2 * STATS_LINE_HEIGHT, STATS_FONT_SIZE, STATS_COLOR);
+
+    if (g_view_waypoints.count > 0)
+    {
+        DrawText(TextFormat("smoothed: %u waypoints", g_view_waypoints.count),
+                 STATS_X_POS, 3 * STATS_LINE_HEIGHT, STATS_FONT_SIZE, STATS_COLOR);
+    }
+}
+
+static void
+texture_destroy(GridTexture* texture)
+{
+    if (texture->pixels == NULL) return;
+
+    UnloadTexture(texture->texture);
+
+    free(texture->pixels);
+    free(texture->wall);
+    free(texture->visited);
+    free(texture->frontier);
+    free(texture->path);
+
+    *texture = (GridTexture){0};
+}
+
+static void
+texture_create(GridTexture* texture, const Grid* grid)
+{
+    texture_destroy(texture);
+
+    u64 cell_count = (u64)grid->rows * grid->cols;
+
+    texture->rows       = grid->rows;
+    texture->cols       = grid->cols;
+    texture->word_count = (cell_count + 63) / 64;
+    texture->pixels     = malloc(cell_count * sizeof(Color));
+    texture->wall       = malloc(texture->word_count * sizeof(u64));
+    texture->visited    = malloc(texture->word_count * sizeof(u64));
+    texture->frontier   = malloc(texture->word_count * sizeof(u64));
+    texture->path       = calloc(texture->word_count, sizeof(u64));
+    texture->start      = grid->start;
+    texture->goal       = grid->goal;
+
+    memcpy(texture->wall,     grid->wall,      texture->word_count * sizeof(u64));
+    memcpy(texture->visited,  g_view_visited,  texture->word_count * sizeof(u64));
+    memcpy(texture->frontier, g_view_frontier, texture->word_count * sizeof(u64));
+
+    for (u64 cell = 0; cell < cell_count; ++cell)
+    {
+        if (animateIsOnPath(cell) == 1) gridBitSet(texture->path, cell);
+        texture->pixels[cell] = cell_color(grid, cell);
+    }
+
+    Image image = {
+        .data       = texture->pixels,
+        .width      = grid->cols,
+        .height     = grid->rows,
+        .mipmaps    = 1,
+        .format     = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+    };
+
+    texture->texture = LoadTextureFromImage(image);
+    SetTextureFilter(texture->texture, TEXTURE_FILTER_POINT);
+
+    LOG_DEBUG("Grid texture: %u x %u", grid->cols, grid->rows);
+}
+
+static void
+texture_recolor(GridTexture* texture, const Grid* grid, u32 cell, u32* first_row, u32* last_row)
+{
+    u32 row = cell / texture->cols;
+
+    texture->pixels[cell] = cell_color(grid, cell);
+
+    if (row < *first_row) *first_row = row;
+    if (row > *last_row)  *last_row  = row;
+}
+
+// Recolors the cells that changed since the last frame and uploads the rows
+// between the first and the last of them
+static void
+texture_update(GridTexture* texture, const Grid* grid)
+{
+    if (texture->pixels == NULL || texture->rows != grid->rows || texture->cols != grid->cols)
+    {
+        texture_create(texture, grid);
+        return;
+    }
+
+    const u64* path      = animateGetPathCells();
+    u32        first_row = UINT32_MAX;
+    u32        last_row  = 0;
+
+    for (u64 word = 0; word < texture->word_count; ++word)
+    {
+        u64 path_bits = path != NULL ? path[word] : 0;
+        u64 changed   = (grid->wall[word]       ^ texture->wall[word]) |
+                        (g_view_visited[word]  ^ texture->visited[word]) |
+                        (g_view_frontier[word] ^ texture->frontier[word]) |
+                        (path_bits             ^ texture->path[word]);
+        if (changed == 0) continue;
+
+        texture->wall[word]     = grid->wall[word];
+        texture->visited[word]  = g_view_visited[word];
+        texture->frontier[word] = g_view_frontier[word];
+        texture->path[word]     = path_bits;
+
+        for (; changed != 0; changed &= changed - 1)
+        {
+            u32 cell = word * 64 + __builtin_ctzll(changed);
+            texture_recolor(texture, grid, cell, &first_row, &last_row);
+        }
+    }
+
+    if (grid->start != texture->start)
+    {
+        if (texture->start != GRID_NO_CELL) texture_recolor(texture, grid, texture->start, &first_row, &last_row);
+        if (grid->start    != GRID_NO_CELL) texture_recolor(texture, grid, grid->start,    &first_row, &last_row);
+        texture->start = grid->start;
+    }
+
+    if (grid->goal != texture->goal)
+    {
+        if (texture->goal != GRID_NO_CELL) texture_recolor(texture, grid, texture->goal, &first_row, &last_row);
+        if (grid->goal    != GRID_NO_CELL) texture_recolor(texture, grid, grid->goal,    &first_row, &last_row);
+        texture->goal = grid->goal;
+    }
+
+    if (first_row > last_row) return;
+
+    Rectangle band = { 0, first_row, texture->cols, last_row - first_row + 1 };
+    UpdateTextureRec(texture->texture, band, &texture->pixels[(u64)first_row * texture->cols]);
+}
+
+void
+gridViewDestroy(void)
+{
+    // Joined first, the worker may still be stepping on the grid
+    searchWorkerDestroy();
+
+    texture_destroy(&g_view_texture);
+    animateDestroy();
+    searchPathFree(&g_view_waypoints);
+
+    free(g_view_visited);
+    free(g_view_frontier);
+    g_view_visited    = NULL;
+    g_view_frontier   = NULL;
+    g_view_word_count = 0;
+}
+
+void
+gridDraw(void)
+{
+    Grid* grid = gridGet();
+
+    texture_update(&g_view_texture, grid);
+
+    Rectangle source = { 0, 0, grid->cols, grid->rows };
+    Rectangle target = { WINDOW_MARGIN, WINDOW_MARGIN, g_view_width, g_view_height };
+    DrawTexturePro(g_view_texture.texture, source, target, (Vector2){ 0, 0 }, 0.0f, WHITE);
+
+    // Leave a one pixel grid line only while cells are large enough to show it
+    if (g_view_width >= 3 * grid->cols && g_view_height >= 3 * grid->rows)
+    {
+        for (u32 col = 1; col <= grid->cols; ++col)
+        {
+            u32 x_pos = WINDOW_MARGIN + view_offset(col, g_view_width, grid->cols) - 1;
+            DrawRectangle(x_pos, WINDOW_MARGIN, 1, g_view_height, BLACK);
+        }
+
+        for (u32 row = 1; row <= grid->rows; ++row)
+        {
+            u32 y_pos = WINDOW_MARGIN + view_offset(row, g_view_height, grid->rows) - 1;
+            DrawRectangle(WINDOW_MARGIN, y_pos, g_view_width, 1, BLACK);
+        }
+    }
+
+    // Waypoint lines, once the animation reached the goal
+    const SearchPath* waypoints = &g_view_waypoints;
+    if (waypoints->count > 1 && animateIsOnPath(waypoints->cells[waypoints->count - 1]) == 1)
+    {
+        for (u32 i = 0; i + 1 < waypoints->count; ++i)
+        {
+            u32      from  = waypoints->cells[i];
+            u32      to    = waypoints->cells[i + 1];
+            CellRect begin = cell_rect(from / grid->cols, from % grid->cols);
+            CellRect end   = cell_rect(to / grid->cols, to % grid->cols);
+
+            DrawLineEx((Vector2){ begin.x_pos + begin.width / 2.0f, begin.y_pos + begin.height / 2.0f },
+                       (Vector2){ end.x_pos + end.width / 2.0f, end.y_pos + end.height / 2.0f },
+                       WAYPOINT_LINE_WIDTH, CELL_WAYPOINT_COLOR);
+        }
+    }
+
+    // Outline of the rectangle being dragged
+    if (g_view_rect_anchor != GRID_NO_CELL)
+    {
+        u32 top, bottom, left, right;
+        rect_bounds(g_view_rect_anchor, g_view_rect_corner, &top, &bottom, &left, &right);
+
+        CellRect first = cell_rect(top, left);
+        CellRect last  = cell_rect(bottom, right);
+
+        DrawRectangleLines(first.x_pos, first.y_pos, last.x_pos + last.width - first.x_pos,
+                           last.y_pos + last.height - first.y_pos, CELL_SOLUTION_COLOR);
+    }
+}
@@ -0,0 +1,584 @@
+#include "hpa.h"
+
+#include "logger.h"
+
+#include "grid.h"
+#include "grid_neighbors.h"
+#include "search.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Runs of crossable border cells at least this long get an entrance at both ends
+#define HPA_LONG_ENTRANCE   6
+
+#define HPA_LOCAL_CELLS     (HPA_CLUSTER_SIZE * HPA_CLUSTER_SIZE)
+#define HPA_MAX_NODES       (4 * HPA_CLUSTER_SIZE)
+
+typedef enum {
+    HPA_SIDE_UP     = 0,
+    HPA_SIDE_DOWN   = 1,
+    HPA_SIDE_LEFT   = 2,
+    HPA_SIDE_RIGHT  = 3,
+    HPA_SIDE_COUNT
+} HpaSide;
+
+typedef struct HpaCluster
+{
+    u32     row;
+    u32     col;
+    u32     rows;
+    u32     cols;
+
+    u32     node_count;
+    u32     nodes[HPA_MAX_NODES];   // cells on the cluster border
+    u32*    cost;                   // cost[i * node_count + j] from node i to node j inside the cluster
+    b8      is_dirty;
+} HpaCluster;
+
+// Abstraction, kept between queries
+static HpaCluster*   g_hpa_clusters       = NULL;
+static u32           g_hpa_cluster_rows   = 0;
+static u32           g_hpa_cluster_cols   = 0;
+static u32*          g_hpa_node_index     = NULL;   // position in its cluster's nodes, GRID_NO_CELL if not a node
+static u64           g_hpa_cells          = 0;
+static u64           g_hpa_node_count     = 0;
+static u32           g_hpa_revision       = 0;
+static b8            g_hpa_is_stale       = 1;
+
+// Query
+static PriorityQueue g_hpa_queue          = {0};
+static u32*          g_hpa_start_cost     = NULL;   // start to every node of its cluster
+static u32*          g_hpa_goal_cost      = NULL;   // every node of its cluster to the goal
+static u32           g_hpa_direct_cost    = GRID_INFINITY;
+static b8            g_hpa_is_running     = 0;
+static b8            g_hpa_has_finished   = 0;
+
+// Single-cluster Dijkstra scratch, indexed by position inside the cluster
+static u32           g_hpa_local_distance[HPA_LOCAL_CELLS];
+static u32           g_hpa_local_parent[HPA_LOCAL_CELLS];
+
+static u32
+cluster_of(const Grid* grid, u32 cell)
+{
+    u32 row = cell / grid->cols / HPA_CLUSTER_SIZE;
+    u32 col = cell % grid->cols / HPA_CLUSTER_SIZE;
+
+    return row * g_hpa_cluster_cols + col;
+}
+
+static u32
+local_index(const Grid* grid, const HpaCluster* cluster, u32 cell)
+{
+    return (cell / grid->cols - cluster->row) * cluster->cols + (cell % grid->cols - cluster->col);
+}
+
+static u32
+global_cell(const Grid* grid, const HpaCluster* cluster, u32 local)
+{
+    return (cluster->row + local / cluster->cols) * grid->cols + cluster->col + local % cluster->cols;
+}
+
+// Dijkstra that never leaves the cluster. With reverse set the distances are
+// from every cell to from instead of the other way around. Stops once target
+// is settled, GRID_NO_CELL explores the whole cluster.
+static void
+local_dijkstra(const Grid* grid, const HpaCluster* cluster, u32 from, b8 reverse, u32 target)
+{
+    u32 count = cluster->rows * cluster->cols;
+
+    memset(g_hpa_local_distance, 0xFF, count * sizeof(u32));
+    memset(g_hpa_local_parent,   0xFF, count * sizeof(u32));
+
+    PriorityQueue queue = pqCreate(PQ_DARY, count, 0);
+
+    u32 source       = local_index(grid, cluster, from);
+    u32 local_target = target == GRID_NO_CELL ? GRID_NO_CELL : local_index(grid, cluster, target);
+
+    g_hpa_local_distance[source] = 0;
+    pqPush(&queue, source, 0);
+
+    while (pqIsEmpty(&queue) == 0)
+    {
+        PQEntry entry;
+        pqPop(&queue, &entry);
+
+        u32 local = entry.cell;
+        if (local == local_target) break;
+
+        u32 row  = local / cluster->cols;
+        u32 col  = local % cluster->cols;
+        u32 cell = global_cell(grid, cluster, local);
+
+        u32 neighbors[4];
+        u32 neighbor_count = 0;
+
+        if (row > 0)                    neighbors[neighbor_count++] = local - cluster->cols;
+        if (col > 0)                    neighbors[neighbor_count++] = local - 1;
+        if (row + 1 < cluster->rows)    neighbors[neighbor_count++] = local + cluster->cols;
+        if (col + 1 < cluster->cols)    neighbors[neighbor_count++] = local + 1;
+
+        for (u32 i = 0; i < neighbor_count; ++i)
+        {
+            u32 neighbor      = neighbors[i];
+            u32 neighbor_cell = global_cell(grid, cluster, neighbor);
+            if (gridIsWall(grid, neighbor_cell) == 1) continue;
+
+            // Entering a cell costs its weight, backwards that is the cell being left
+            u32 weight = reverse == 1 ? grid->weight[cell] : grid->weight[neighbor_cell];
+            u64 temp   = (u64)g_hpa_local_distance[local] + weight;
+
+            if (temp < g_hpa_local_distance[neighbor])
+            {
+                g_hpa_local_distance[neighbor] = temp;
+                g_hpa_local_parent[neighbor]   = local;
+                pqPush(&queue, neighbor, temp);
+            }
+        }
+    }
+
+    pqDestroy(&queue);
+}
+
+// ---------------------------------------------------------------------------
+// Abstraction
+// ---------------------------------------------------------------------------
+
+static void
+add_node(HpaCluster* cluster, u32 cell)
+{
+    if (g_hpa_node_index[cell] != GRID_NO_CELL) return;
+
+    g_hpa_node_index[cell]                 = cluster->node_count;
+    cluster->nodes[cluster->node_count++]  = cell;
+}
+
+// Walks the border shared with the next cluster on that side. Both clusters
+// walk it in the same order, so they pick matching cells.
+static void
+add_border_nodes(const Grid* grid, HpaCluster* cluster, HpaSide side)
+{
+    b8  is_row = side == HPA_SIDE_UP || side == HPA_SIDE_DOWN;
+    u32 length = is_row ? cluster->cols : cluster->rows;
+
+    i64 inside, outside;
+    switch (side)
+    {
+        case HPA_SIDE_UP:       inside = cluster->row;                      outside = inside - 1; break;
+        case HPA_SIDE_DOWN:     inside = cluster->row + cluster->rows - 1;  outside = inside + 1; break;
+        case HPA_SIDE_LEFT:     inside = cluster->col;                      outside = inside - 1; break;
+        default:                inside = cluster->col + cluster->cols - 1;  outside = inside + 1; break;
+    }
+
+    if (outside < 0 || outside >= (is_row ? grid->rows : grid->cols)) return;
+
+    i64 run_begin = -1;
+    for (u32 i = 0; i <= length; ++i)
+    {
+        b8 is_open = 0;
+        if (i < length)
+        {
+            u32 in_cell  = is_row ? inside  * grid->cols + cluster->col + i : (cluster->row + i) * grid->cols + inside;
+            u32 out_cell = is_row ? outside * grid->cols + cluster->col + i : (cluster->row + i) * grid->cols + outside;
+
+            is_open = gridIsWall(grid, in_cell) == 0 && gridIsWall(grid, out_cell) == 0;
+        }
+
+        if (is_open == 1 && run_begin < 0) run_begin = i;
+        if (is_open == 1 || run_begin < 0) continue;
+
+        // A run of open pairs just ended
+        u32 run_end = i - 1;
+        u32 picks[2];
+        u32 pick_count = 0;
+
+        if (run_end - run_begin + 1 >= HPA_LONG_ENTRANCE)
+        {
+            picks[pick_count++] = run_begin;
+            picks[pick_count++] = run_end;
+        }
+        else
+        {
+            picks[pick_count++] = (run_begin + run_end) / 2;
+        }
+
+        for (u32 p = 0; p < pick_count; ++p)
+        {
+            u32 cell = is_row ? inside * grid->cols + cluster->col + picks[p] : (cluster->row + picks[p]) * grid->cols + inside;
+            add_node(cluster, cell);
+        }
+
+        run_begin = -1;
+    }
+}
+
+static void
+build_cluster(const Grid* grid, HpaCluster* cluster)
+{
+    for (u32 i = 0; i < cluster->node_count; ++i) g_hpa_node_index[cluster->nodes[i]] = GRID_NO_CELL;
+
+    g_hpa_node_count    -= cluster->node_count;
+    cluster->node_count  = 0;
+
+    for (u32 side = 0; side < HPA_SIDE_COUNT; ++side) add_border_nodes(grid, cluster, side);
+
+    u32 count     = cluster->node_count;
+    cluster->cost = realloc(cluster->cost, (count * count + 1) * sizeof(u32));
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        local_dijkstra(grid, cluster, cluster->nodes[i], 0, GRID_NO_CELL);
+
+        for (u32 j = 0; j < count; ++j)
+        {
+            cluster->cost[i * count + j] = g_hpa_local_distance[local_index(grid, cluster, cluster->nodes[j])];
+        }
+    }
+
+    g_hpa_node_count  += count;
+    cluster->is_dirty  = 0;
+}
+
+static void
+destroy_abstraction(void)
+{
+    if (g_hpa_clusters != NULL)
+    {
+        for (u32 i = 0; i < g_hpa_cluster_rows * g_hpa_cluster_cols; ++i) free(g_hpa_clusters[i].cost);
+    }
+
+    free(g_hpa_clusters);
+    free(g_hpa_node_index);
+
+    g_hpa_clusters   = NULL;
+    g_hpa_node_index = NULL;
+    g_hpa_node_count = 0;
+}
+
+static void
+build_abstraction(const Grid* grid)
+{
+    destroy_abstraction();
+
+    g_hpa_cells         = gridGetCellCount();
+    g_hpa_cluster_rows  = (grid->rows + HPA_CLUSTER_SIZE - 1) / HPA_CLUSTER_SIZE;
+    g_hpa_cluster_cols  = (grid->cols + HPA_CLUSTER_SIZE - 1) / HPA_CLUSTER_SIZE;
+    g_hpa_clusters      = calloc((u64)g_hpa_cluster_rows * g_hpa_cluster_cols, sizeof(HpaCluster));
+    g_hpa_node_index    = malloc(g_hpa_cells * sizeof(u32));
+    memset(g_hpa_node_index, 0xFF, g_hpa_cells * sizeof(u32));
+
+    for (u32 row = 0; row < g_hpa_cluster_rows; ++row)
+    {
+        for (u32 col = 0; col < g_hpa_cluster_cols; ++col)
+        {
+            HpaCluster* cluster = &g_hpa_clusters[row * g_hpa_cluster_cols + col];
+
+            cluster->row  = row * HPA_CLUSTER_SIZE;
+            cluster->col  = col * HPA_CLUSTER_SIZE;
+            cluster->rows = grid->rows - cluster->row < HPA_CLUSTER_SIZE ? grid->rows - cluster->row : HPA_CLUSTER_SIZE;
+            cluster->cols = grid->cols - cluster->col < HPA_CLUSTER_SIZE ? grid->cols - cluster->col : HPA_CLUSTER_SIZE;
+
+            build_cluster(grid, cluster);
+        }
+    }
+
+    g_hpa_revision = grid->revision;
+    g_hpa_is_stale = 0;
+
+    LOG_DEBUG("HPA*: %u x %u clusters, %lu nodes", g_hpa_cluster_rows, g_hpa_cluster_cols, g_hpa_node_count);
+}
+
+static void
+rebuild_dirty_clusters(const Grid* grid)
+{
+    u32 rebuilt = 0;
+
+    for (u32 i = 0; i < g_hpa_cluster_rows * g_hpa_cluster_cols; ++i)
+    {
+        if (g_hpa_clusters[i].is_dirty == 0) continue;
+
+        build_cluster(grid, &g_hpa_clusters[i]);
+        rebuilt += 1;
+    }
+
+    if (rebuilt > 0) LOG_DEBUG("HPA*: rebuilt %u clusters", rebuilt);
+}
+
+// ---------------------------------------------------------------------------
+// Query
+// ---------------------------------------------------------------------------
+
+static void
+relax(Grid* grid, SearchStats* stats, u32 from, u32 to, u32 cost)
+{
+    if (cost == GRID_INFINITY || gridIsVisited(grid, to) == 1) return;
+
+    gridTouch(grid, to);
+
+    u64 temp = (u64)grid->distance[from] + cost;
+    if (temp < grid->distance[to])
+    {
+        grid->distance[to] = temp;
+        grid->parent[to]   = from;
+        pqPush(&g_hpa_queue, to, temp + gridManhattanDistance(grid, to, grid->goal));
+        searchStatsQueuePush(stats, g_hpa_queue.size);
+    }
+}
+
+static void
+append_cell(u32** path, u64* size, u64* capacity, u32 cell)
+{
+    if (*size == *capacity)
+    {
+        *capacity = *capacity > 0 ? *capacity * 2 : 256;
+        *path     = realloc(*path, *capacity * sizeof(u32));
+    }
+
+    (*path)[(*size)++] = cell;
+}
+
+// Replaces the abstract hops in parent[] with grid cells
+static void
+refine_path(Grid* grid)
+{
+    u64 hop_count = 0;
+    for (u32 cell = grid->goal; cell != GRID_NO_CELL; cell = grid->parent[cell]) hop_count += 1;
+
+    u32* hops = malloc(hop_count * sizeof(u32));
+    u64  i    = 0;
+    for (u32 cell = grid->goal; cell != GRID_NO_CELL; cell = grid->parent[cell]) hops[i++] = cell;
+
+    u32* path     = NULL;
+    u64  size     = 0;
+    u64  capacity = 0;
+    append_cell(&path, &size, &capacity, grid->start);
+
+    for (u64 hop = hop_count - 1; hop > 0; --hop)
+    {
+        u32 from = hops[hop];
+        u32 to   = hops[hop - 1];
+
+        // Hops between clusters join two neighboring cells
+        if (cluster_of(grid, from) != cluster_of(grid, to))
+        {
+            append_cell(&path, &size, &capacity, to);
+            continue;
+        }
+
+        HpaCluster* cluster = &g_hpa_clusters[cluster_of(grid, from)];
+        local_dijkstra(grid, cluster, from, 0, to);
+
+        u64 segment_begin = size;
+        for (u32 local = local_index(grid, cluster, to); local != local_index(grid, cluster, from); local = g_hpa_local_parent[local])
+        {
+            append_cell(&path, &size, &capacity, global_cell(grid, cluster, local));
+        }
+
+        // The segment was collected from its end
+        for (u64 a = segment_begin, b = size - 1; a < b; ++a, --b)
+        {
+            u32 temp = path[a];
+            path[a]  = path[b];
+            path[b]  = temp;
+        }
+    }
+
+    // Written from the goal back, so a cell's first visit wins and loops
+    // through a cluster entered twice drop out of the chain
+    for (u64 index = size - 1; index > 0; --index)
+    {
+        gridTouch(grid, path[index]);
+        grid->parent[path[index]] = path[index - 1];
+    }
+    grid->parent[grid->start] = GRID_NO_CELL;
+
+    free(path);
+    free(hops);
+}
+
+static void
+finish(void)
+{
+    pqDestroy(&g_hpa_queue);
+
+    free(g_hpa_start_cost);
+    free(g_hpa_goal_cost);
+    g_hpa_start_cost = NULL;
+    g_hpa_goal_cost  = NULL;
+
+    g_hpa_is_running    = 0;
+    g_hpa_has_finished  = 1;
+}
+
+void
+hpaInit(u64 capacity, PriorityQueueKind queue)
+{
+    Grid* grid = gridGet();
+
+    // A search cancelled or restarted before it finished still holds its queue and costs
+    if (g_hpa_is_running == 1) finish();
+
+    if (g_hpa_clusters == NULL || g_hpa_is_stale == 1 ||
+        g_hpa_cells != gridGetCellCount() || g_hpa_revision != grid->revision)
+    {
+        build_abstraction(grid);
+    }
+    else
+    {
+        rebuild_dirty_clusters(grid);
+    }
+
+    // Abstract edges can cross a whole cluster, too far apart for Dial's buckets
+    if (queue == PQ_BUCKET) queue = PQ_RADIX;
+    g_hpa_queue = pqCreate(queue, capacity, 0);
+
+    // Connect the start and the goal to the nodes of their clusters
+    HpaCluster* start_cluster = &g_hpa_clusters[cluster_of(grid, grid->start)];
+    HpaCluster* goal_cluster  = &g_hpa_clusters[cluster_of(grid, grid->goal)];
+
+    local_dijkstra(grid, start_cluster, grid->start, 0, GRID_NO_CELL);
+
+    g_hpa_start_cost = malloc((start_cluster->node_count + 1) * sizeof(u32));
+    for (u32 i = 0; i < start_cluster->node_count; ++i)
+    {
+        g_hpa_start_cost[i] = g_hpa_local_distance[local_index(grid, start_cluster, start_cluster->nodes[i])];
+    }
+
+    g_hpa_direct_cost = start_cluster == goal_cluster
+        ? g_hpa_local_distance[local_index(grid, start_cluster, grid->goal)]
+        : GRID_INFINITY;
+
+    local_dijkstra(grid, goal_cluster, grid->goal, 1, GRID_NO_CELL);
+
+    g_hpa_goal_cost = malloc((goal_cluster->node_count + 1) * sizeof(u32));
+    for (u32 i = 0; i < goal_cluster->node_count; ++i)
+    {
+        g_hpa_goal_cost[i] = g_hpa_local_distance[local_index(grid, goal_cluster, goal_cluster->nodes[i])];
+    }
+
+    gridTouch(grid, grid->start);
+    grid->distance[grid->start] = 0;
+
+    pqPush(&g_hpa_queue, grid->start, gridManhattanDistance(grid, grid->start, grid->goal));
+    searchStatsQueuePush(searchGetStats(), g_hpa_queue.size);
+
+    g_hpa_is_running    = 1;
+    g_hpa_has_finished  = 0;
+}
+
+void
+hpaStep(void)
+{
+    if (g_hpa_is_running == 0 || g_hpa_has_finished == 1) return;
+
+    Grid*        grid  = gridGet();
+    SearchStats* stats = searchGetStats();
+
+    if (pqIsEmpty(&g_hpa_queue) == 1)
+    {
+        LOG_INFO("Could not find path!");
+        finish();
+        return;
+    }
+
+    PQEntry entry;
+    pqPop(&g_hpa_queue, &entry);
+    searchStatsPop(stats);
+
+    u32 cell = entry.cell;
+    if (gridIsVisited(grid, cell) == 1)
+    {
+        stats->stale_pops += 1;
+        return;
+    }
+    gridMarkVisited(grid, cell);
+    stats->expanded += 1;
+
+    if (cell == grid->goal)
+    {
+        LOG_INFO("Found path!");
+        LOG_INFO("Abstract distance %u", grid->distance[cell]);
+
+        refine_path(grid);
+        finish();
+        return;
+    }
+
+    u32         cluster_index = cluster_of(grid, cell);
+    HpaCluster* cluster       = &g_hpa_clusters[cluster_index];
+    u32         node          = g_hpa_node_index[cell];
+    b8          in_goal       = cluster_index == cluster_of(grid, grid->goal);
+
+    // Inside the cluster
+    if (cell == grid->start)
+    {
+        for (u32 i = 0; i < cluster->node_count; ++i) relax(grid, stats, cell, cluster->nodes[i], g_hpa_start_cost[i]);
+
+        if (in_goal == 1) relax(grid, stats, cell, grid->goal, g_hpa_direct_cost);
+    }
+    else if (node != GRID_NO_CELL)
+    {
+        u32* cost = &cluster->cost[node * cluster->node_count];
+        for (u32 i = 0; i < cluster->node_count; ++i) relax(grid, stats, cell, cluster->nodes[i], cost[i]);
+
+        if (in_goal == 1) relax(grid, stats, cell, grid->goal, g_hpa_goal_cost[node]);
+    }
+
+    if (node == GRID_NO_CELL) return;
+
+    // Across a border, to the matching node of the next cluster
+    u32 neighbors[8];
+    u32 neighbor_count = gridOpenNeighbors(grid, cell, GRID_CONNECT_4, neighbors, NULL);
+
+    for (u32 i = 0; i < neighbor_count; ++i)
+    {
+        u32 neighbor = neighbors[i];
+
+        if (g_hpa_node_index[neighbor] == GRID_NO_CELL || cluster_of(grid, neighbor) == cluster_index) continue;
+
+        relax(grid, stats, cell, neighbor, grid->weight[neighbor]);
+    }
+}
+
+b8
+hpaShouldStop(void)
+{
+    return (g_hpa_is_running == 0) && (g_hpa_has_finished == 1);
+}
+
+void
+hpaCellChanged(u32 cell)
+{
+    Grid* grid = gridGet();
+
+    if (g_hpa_clusters == NULL || g_hpa_is_stale == 1) return;
+    if (grid->revision == g_hpa_revision) return;
+
+    // An edit made without a notification in between: start over on the next query
+    if (g_hpa_cells != gridGetCellCount() || grid->revision != g_hpa_revision + 1)
+    {
+        g_hpa_is_stale = 1;
+        return;
+    }
+
+    g_hpa_revision = grid->revision;
+
+    u32         index   = cluster_of(grid, cell);
+    HpaCluster* cluster = &g_hpa_clusters[index];
+    cluster->is_dirty   = 1;
+
+    // A border cell also moves the entrances of the cluster next to it
+    u32 row = cell / grid->cols;
+    u32 col = cell % grid->cols;
+
+    if (row == cluster->row && row > 0)                                 g_hpa_clusters[index - g_hpa_cluster_cols].is_dirty = 1;
+    if (row == cluster->row + cluster->rows - 1 && row + 1 < grid->rows) g_hpa_clusters[index + g_hpa_cluster_cols].is_dirty = 1;
+    if (col == cluster->col && col > 0)                                 g_hpa_clusters[index - 1].is_dirty = 1;
+    if (col == cluster->col + cluster->cols - 1 && col + 1 < grid->cols) g_hpa_clusters[index + 1].is_dirty = 1;
+}
+
+u64
+hpaGetNodeCount(void)
+{
+    return g_hpa_node_count;
+}
@@ -0,0 +1,355 @@
+#include "jps.h"
+
+#include "logger.h"
+
+#include "grid.h"
+#include "grid_neighbors.h"
+#include "search.h"
+
+#include <stdlib.h>
+
+// Canonical 4-connected paths: a horizontal jump stops at cells with a forced
+// neighbor, a vertical jump also stops where a horizontal jump would find a
+// jump point. Every jump point then only needs to look forward and sideways.
+typedef enum {
+    JPS_UP      = 0,
+    JPS_DOWN    = 1,
+    JPS_LEFT    = 2,
+    JPS_RIGHT   = 3,
+    JPS_DIR_COUNT
+} JpsDir;
+
+static const i32 g_jps_d_row[JPS_DIR_COUNT] = { -1, 1,  0, 0 };
+static const i32 g_jps_d_col[JPS_DIR_COUNT] = {  0, 0, -1, 1 };
+
+static PriorityQueue g_jps_queue          = {0};
+static b8            g_jps_use_table      = 0;
+static b8            g_jps_is_running     = 0;
+static b8            g_jps_has_finished   = 0;
+
+// JPS+ table, 4 entries per cell: d > 0 is the distance to the next jump
+// point, d <= 0 means -d free cells until a wall or the border
+static i32*          g_jps_table          = NULL;
+static u64           g_jps_table_cells    = 0;
+static u32           g_jps_table_revision = 0;
+
+static b8
+is_free(const Grid* grid, i64 row, i64 col)
+{
+    if (row < 0 || row >= grid->rows || col < 0 || col >= grid->cols) return 0;
+
+    return gridIsWall(grid, col + grid->cols * row) == 0;
+}
+
+static b8
+has_forced_horizontal(const Grid* grid, i64 row, i64 col, i64 d_col)
+{
+    return (is_free(grid, row - 1, col) && !is_free(grid, row - 1, col - d_col)) ||
+           (is_free(grid, row + 1, col) && !is_free(grid, row + 1, col - d_col));
+}
+
+static b8
+has_forced_vertical(const Grid* grid, i64 row, i64 col, i64 d_row)
+{
+    return (is_free(grid, row, col - 1) && !is_free(grid, row - d_row, col - 1)) ||
+           (is_free(grid, row, col + 1) && !is_free(grid, row - d_row, col + 1));
+}
+
+// ---------------------------------------------------------------------------
+// Online jumps
+// ---------------------------------------------------------------------------
+
+static u32
+jump_horizontal(const Grid* grid, i64 row, i64 col, i64 d_col)
+{
+    for (;;)
+    {
+        col += d_col;
+        if (!is_free(grid, row, col)) return GRID_NO_CELL;
+
+        u32 cell = col + grid->cols * row;
+        if (cell == grid->goal || has_forced_horizontal(grid, row, col, d_col)) return cell;
+    }
+}
+
+static u32
+jump_vertical(const Grid* grid, i64 row, i64 col, i64 d_row)
+{
+    for (;;)
+    {
+        row += d_row;
+        if (!is_free(grid, row, col)) return GRID_NO_CELL;
+
+        u32 cell = col + grid->cols * row;
+        if (cell == grid->goal || has_forced_vertical(grid, row, col, d_row)) return cell;
+
+        if (jump_horizontal(grid, row, col, -1) != GRID_NO_CELL ||
+            jump_horizontal(grid, row, col,  1) != GRID_NO_CELL) return cell;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// JPS+ jump table
+// ---------------------------------------------------------------------------
+
+static i32
+next_distance(i32 next)
+{
+    return next > 0 ? next + 1 : next - 1;
+}
+
+static void
+build_jump_table(const Grid* grid)
+{
+    u64 cell_count = gridGetCellCount();
+
+    if (g_jps_table_cells != cell_count)
+    {
+        free(g_jps_table);
+        g_jps_table       = malloc(cell_count * JPS_DIR_COUNT * sizeof(i32));
+        g_jps_table_cells = cell_count;
+    }
+
+    i64 rows = grid->rows;
+    i64 cols = grid->cols;
+
+    // Horizontal entries only depend on their own row
+    for (i64 row = 0; row < rows; ++row)
+    {
+        for (i64 col = cols - 1; col >= 0; --col)
+        {
+            i32* entry = &g_jps_table[(col + cols * row) * JPS_DIR_COUNT];
+
+            if      (!is_free(grid, row, col + 1))                entry[JPS_RIGHT] = 0;
+            else if (has_forced_horizontal(grid, row, col + 1, 1)) entry[JPS_RIGHT] = 1;
+            else    entry[JPS_RIGHT] = next_distance(entry[JPS_DIR_COUNT + JPS_RIGHT]);
+        }
+
+        for (i64 col = 0; col < cols; ++col)
+        {
+            i32* entry = &g_jps_table[(col + cols * row) * JPS_DIR_COUNT];
+
+            if      (!is_free(grid, row, col - 1))                 entry[JPS_LEFT] = 0;
+            else if (has_forced_horizontal(grid, row, col - 1, -1)) entry[JPS_LEFT] = 1;
+            else    entry[JPS_LEFT] = next_distance(entry[JPS_LEFT - JPS_DIR_COUNT]);
+        }
+    }
+
+    // A vertical jump stops where either horizontal entry finds a jump point
+    i64 stride = cols * JPS_DIR_COUNT;
+
+    for (i64 col = 0; col < cols; ++col)
+    {
+        for (i64 row = rows - 1; row >= 0; --row)
+        {
+            i32* entry = &g_jps_table[(col + cols * row) * JPS_DIR_COUNT];
+            i32* next  = entry + stride;
+
+            if (!is_free(grid, row + 1, col))
+                entry[JPS_DOWN] = 0;
+            else if (has_forced_vertical(grid, row + 1, col, 1) || next[JPS_LEFT] > 0 || next[JPS_RIGHT] > 0)
+                entry[JPS_DOWN] = 1;
+            else
+                entry[JPS_DOWN] = next_distance(next[JPS_DOWN]);
+        }
+
+        for (i64 row = 0; row < rows; ++row)
+        {
+            i32* entry = &g_jps_table[(col + cols * row) * JPS_DIR_COUNT];
+            i32* next  = entry - stride;
+
+            if (!is_free(grid, row - 1, col))
+                entry[JPS_UP] = 0;
+            else if (has_forced_vertical(grid, row - 1, col, -1) || next[JPS_LEFT] > 0 || next[JPS_RIGHT] > 0)
+                entry[JPS_UP] = 1;
+            else
+                entry[JPS_UP] = next_distance(next[JPS_UP]);
+        }
+    }
+
+    g_jps_table_revision = grid->revision;
+
+    LOG_DEBUG("Built JPS+ table for %lu cells", cell_count);
+}
+
+// Same result as the online jump, including stopping for the goal
+static u32
+jump_table(const Grid* grid, u32 cell, JpsDir dir)
+{
+    i64 row      = cell / grid->cols;
+    i64 col      = cell % grid->cols;
+    i64 goal_row = grid->goal / grid->cols;
+    i64 goal_col = grid->goal % grid->cols;
+
+    i32 d     = g_jps_table[(u64)cell * JPS_DIR_COUNT + dir];
+    i64 reach = d > 0 ? d : -d;
+
+    // Steps along dir until the goal row (vertical) or goal column (horizontal)
+    i64 steps = dir == JPS_UP   ? row - goal_row :
+                dir == JPS_DOWN ? goal_row - row :
+                dir == JPS_LEFT ? col - goal_col :
+                                  goal_col - col;
+
+    if (steps >= 1 && steps <= reach)
+    {
+        if (dir == JPS_LEFT || dir == JPS_RIGHT)
+        {
+            if (row == goal_row) return grid->goal;
+        }
+        else if (d <= 0 || steps < d)
+        {
+            // The turning cell isn't a jump point, so its horizontal entries
+            // are free runs and tell whether the goal is in sight
+            u32 turn   = col + grid->cols * goal_row;
+            i32 across = g_jps_table[(u64)turn * JPS_DIR_COUNT + (goal_col < col ? JPS_LEFT : JPS_RIGHT)];
+            i64 offset = goal_col > col ? goal_col - col : col - goal_col;
+
+            if (offset <= -across) return turn;
+        }
+    }
+
+    if (d <= 0) return GRID_NO_CELL;
+
+    return (col + g_jps_d_col[dir] * d) + grid->cols * (row + g_jps_d_row[dir] * d);
+}
+
+// ---------------------------------------------------------------------------
+
+// Jump points are joined by straight segments, fill in the cells between them
+static void
+expand_path(Grid* grid)
+{
+    u32 cell = grid->goal;
+
+    while (grid->parent[cell] != GRID_NO_CELL)
+    {
+        u32 jump_point = grid->parent[cell];
+        i64 step       = cell / grid->cols == jump_point / grid->cols ? 1 : grid->cols;
+        if (jump_point > cell) step = -step;
+
+        for (u32 between = cell - step; between != jump_point; between -= step)
+        {
+            gridTouch(grid, between);
+
+            grid->parent[cell] = between;
+            cell               = between;
+        }
+
+        grid->parent[cell] = jump_point;
+        cell               = jump_point;
+    }
+}
+
+void
+jpsInit(u64 capacity, PriorityQueueKind queue, b8 use_jump_table)
+{
+    Grid* grid = gridGet();
+
+    // A search cancelled or restarted before it finished still holds its queue
+    if (g_jps_is_running == 1) pqDestroy(&g_jps_queue);
+
+    // A jump moves at most rows + cols cells and f grows by at most twice that
+    g_jps_queue = pqCreate(queue, capacity, 2 * (grid->rows + grid->cols));
+
+    g_jps_use_table = use_jump_table;
+    if (use_jump_table == 1 &&
+        (g_jps_table_cells != gridGetCellCount() || g_jps_table_revision != grid->revision))
+    {
+        build_jump_table(grid);
+    }
+
+    gridTouch(grid, grid->start);
+    grid->distance[grid->start] = 0;
+
+    pqPush(&g_jps_queue, grid->start, gridManhattanDistance(grid, grid->start, grid->goal));
+    searchStatsQueuePush(searchGetStats(), g_jps_queue.size);
+
+    g_jps_is_running    = 1;
+    g_jps_has_finished  = 0;
+}
+
+void
+jpsStep(void)
+{
+    if (g_jps_is_running == 0 || g_jps_has_finished == 1) return;
+
+    Grid*        grid  = gridGet();
+    SearchStats* stats = searchGetStats();
+
+    if (pqIsEmpty(&g_jps_queue) == 1)
+    {
+        LOG_INFO("Could not find path!");
+        g_jps_is_running    = 0;
+        g_jps_has_finished  = 1;
+
+        pqDestroy(&g_jps_queue);
+
+        return;
+    }
+
+    PQEntry entry;
+    pqPop(&g_jps_queue, &entry);
+    searchStatsPop(stats);
+
+    u32 cell = entry.cell;
+    if (gridIsVisited(grid, cell) == 1)
+    {
+        stats->stale_pops += 1;
+        return;
+    }
+    gridMarkVisited(grid, cell);
+    stats->expanded += 1;
+
+    if (cell == grid->goal)
+    {
+        LOG_INFO("Found path!");
+        LOG_INFO("Distance %u", grid->distance[cell]);
+        g_jps_is_running    = 0;
+        g_jps_has_finished  = 1;
+
+        expand_path(grid);
+        pqDestroy(&g_jps_queue);
+
+        return;
+    }
+
+    i64 row = cell / grid->cols;
+    i64 col = cell % grid->cols;
+
+    // Never jump back towards the parent
+    u32 parent = grid->parent[cell];
+    i32 back   = -1;
+    if (parent != GRID_NO_CELL)
+    {
+        if (parent / grid->cols == cell / grid->cols)   back = parent < cell ? JPS_LEFT : JPS_RIGHT;
+        else                                            back = parent < cell ? JPS_UP   : JPS_DOWN;
+    }
+
+    for (u8 dir = 0; dir < JPS_DIR_COUNT; ++dir)
+    {
+        if (dir == back) continue;
+
+        u32 jump_point;
+        if (g_jps_use_table == 1)       jump_point = jump_table(grid, cell, dir);
+        else if (g_jps_d_col[dir] != 0) jump_point = jump_horizontal(grid, row, col, g_jps_d_col[dir]);
+        else                            jump_point = jump_vertical(grid, row, col, g_jps_d_row[dir]);
+
+        if (jump_point == GRID_NO_CELL || gridIsVisited(grid, jump_point) == 1) continue;
+
+        gridTouch(grid, jump_point);
+        u64 temp = (u64)grid->distance[cell] + gridManhattanDistance(grid, cell, jump_point);
+        if (temp < grid->distance[jump_point])
+        {
+            grid->distance[jump_point] = temp;
+            grid->parent[jump_point]   = cell;
+            pqPush(&g_jps_queue, jump_point, temp + gridManhattanDistance(grid, jump_point, grid->goal));
+            searchStatsQueuePush(stats, g_jps_queue.size);
+        }
+    }
+}
+
+b8
+jpsShouldStop(void)
+{
+    return (g_jps_is_running == 0) && (g_jps_has_finished == 1);
+}
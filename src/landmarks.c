@@ -0,0 +1,413 @@
+#include "landmarks.h"
+
+#include "logger.h"
+
+#include "priority_queue.h"
+#include "search.h"
+#include "search_batch.h"
+#include "timer.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// "PFLM" when read as a little-endian u32
+#define LANDMARKS_MAGIC     0x4D4C4650u
+#define LANDMARKS_VERSION   1
+
+// Followed by the landmark cells, then the from and the to table
+typedef struct LandmarkFileHeader
+{
+    u32     magic;
+    u32     version;
+    u32     rows;
+    u32     cols;
+    u32     connectivity;
+    u32     requested;
+    u32     count;
+    u32     reserved;
+    u64     map_hash;
+} LandmarkFileHeader;
+
+// The Dijkstra searches of one build. Job j fills column j / 2 of the from
+// table when j is even, of the to table when it is odd.
+typedef struct LandmarkBuild
+{
+    const Grid*         grid;
+    LandmarkTables*     tables;
+    PriorityQueueKind   queue;
+    u32                 max_step;
+    u32                 job_count;
+    u32                 next_job;       // taken with an atomic add
+} LandmarkBuild;
+
+static LandmarkTables g_landmarks       = {0};
+static u32            g_landmarks_count = LANDMARKS_DEFAULT_COUNT;
+
+// FNV-1a over the walls and weights, to tell whether saved tables fit the map
+static u64
+map_hash(const Grid* grid)
+{
+    u64 cell_count = gridGetCellCount();
+    u64 word_count = (cell_count + 63) / 64;
+    u64 hash       = 0xCBF29CE484222325ull;
+
+    for (u64 i = 0; i < word_count; ++i) hash = (hash ^ grid->wall[i])   * 0x100000001B3ull;
+    for (u64 i = 0; i < cell_count; ++i) hash = (hash ^ grid->weight[i]) * 0x100000001B3ull;
+
+    return hash;
+}
+
+// Moves from source to every cell it reaches, GRID_INFINITY for the others
+static void
+count_moves(const Grid* grid, u32 source, u32* moves, u32* fifo)
+{
+    memset(moves, 0xFF, gridGetCellCount() * sizeof(u32));
+
+    u64 head = 0;
+    u64 tail = 0;
+
+    moves[source]  = 0;
+    fifo[tail++]   = source;
+
+    while (head < tail)
+    {
+        u32 cell = fifo[head++];
+
+        u32 neighbors[8];
+        u32 steps[8];
+        u32 count = gridOpenNeighbors(grid, cell, grid->connectivity, neighbors, steps);
+
+        for (u32 i = 0; i < count; ++i)
+        {
+            if (moves[neighbors[i]] != GRID_INFINITY) continue;
+
+            moves[neighbors[i]] = moves[cell] + 1;
+            fifo[tail++]        = neighbors[i];
+        }
+    }
+}
+
+// Farthest-point selection: the first landmark is the cell farthest from the
+// seed, every next one the cell farthest from all landmarks placed so far.
+// Far apart landmarks sit behind most cells as seen from most others, which
+// is where their bounds are tight. Returns the number placed, fewer than
+// requested once every cell of the region holds a landmark.
+static u32
+place_landmarks(const Grid* grid, u32 seed, u32* cells, u32 requested)
+{
+    u64  cell_count = gridGetCellCount();
+    u32* moves      = malloc(cell_count * sizeof(u32));
+    u32* nearest    = malloc(cell_count * sizeof(u32));
+    u32* fifo       = malloc(cell_count * sizeof(u32));
+
+    count_moves(grid, seed, moves, fifo);
+
+    u32 next = seed;
+    for (u64 cell = 0; cell < cell_count; ++cell)
+    {
+        if (moves[cell] != GRID_INFINITY && moves[cell] > moves[next]) next = (u32)cell;
+    }
+
+    // Cells outside the seed's region stay at GRID_INFINITY and are never picked
+    memset(nearest, 0xFF, cell_count * sizeof(u32));
+
+    u32 count = 0;
+    while (count < requested)
+    {
+        cells[count++] = next;
+        count_moves(grid, next, moves, fifo);
+
+        u32 farthest = 0;
+        for (u64 cell = 0; cell < cell_count; ++cell)
+        {
+            if (moves[cell] < nearest[cell]) nearest[cell] = moves[cell];
+            if (nearest[cell] != GRID_INFINITY && nearest[cell] > farthest)
+            {
+                farthest = nearest[cell];
+                next     = (u32)cell;
+            }
+        }
+
+        if (farthest == 0) break;
+    }
+
+    free(moves);
+    free(nearest);
+    free(fifo);
+
+    return count;
+}
+
+static void
+run_dijkstra(LandmarkBuild* build, u32 job, u32* distance, PriorityQueue* queue)
+{
+    const Grid*     grid         = build->grid;
+    LandmarkTables* tables       = build->tables;
+    u32             landmark     = job / 2;
+    b8              reverse      = job % 2 == 1;
+    u32             connectivity = grid->connectivity;
+    u64             cell_count   = tables->cell_count;
+
+    memset(distance, 0xFF, cell_count * sizeof(u32));
+    pqClear(queue);
+
+    u32 source = tables->cells[landmark];
+    distance[source] = 0;
+    pqPush(queue, source, 0);
+
+    while (pqIsEmpty(queue) == 0)
+    {
+        PQEntry entry;
+        pqPop(queue, &entry);
+
+        u32 cell = entry.cell;
+        if (entry.priority > distance[cell]) continue;
+
+        u32 neighbors[8];
+        u32 steps[8];
+        u32 count = gridOpenNeighbors(grid, cell, connectivity, neighbors, steps);
+
+        for (u32 i = 0; i < count; ++i)
+        {
+            // Towards the landmark, the move from each neighbor enters cell
+            u64 cost = reverse == 1
+                ? (u64)grid->weight[cell] * (connectivity == GRID_CONNECT_8 ? steps[i] : 1)
+                : gridMoveCost(grid, connectivity, neighbors, steps, i);
+
+            u64 temp = (u64)distance[cell] + cost;
+            if (temp < distance[neighbors[i]])
+            {
+                distance[neighbors[i]] = temp;
+                pqPush(queue, neighbors[i], temp);
+            }
+        }
+    }
+
+    u32* table = reverse == 1 ? tables->to : tables->from;
+    for (u64 cell = 0; cell < cell_count; ++cell) table[cell * tables->count + landmark] = distance[cell];
+}
+
+static void*
+build_worker(void* argument)
+{
+    LandmarkBuild* build = argument;
+
+    u32*          distance = malloc(build->tables->cell_count * sizeof(u32));
+    PriorityQueue queue    = pqCreate(build->queue, build->tables->cell_count, build->max_step);
+
+    for (;;)
+    {
+        u32 job = __atomic_fetch_add(&build->next_job, 1, __ATOMIC_RELAXED);
+        if (job >= build->job_count) break;
+
+        run_dijkstra(build, job, distance, &queue);
+    }
+
+    pqDestroy(&queue);
+    free(distance);
+
+    return NULL;
+}
+
+static void
+build_tables(void)
+{
+    Grid* grid       = gridGet();
+    u64   cell_count = gridGetCellCount();
+    u64   begin      = timerNowNs();
+
+    landmarksDestroy();
+    gridBuildMoves();
+
+    g_landmarks = (LandmarkTables){
+        .requested      = g_landmarks_count,
+        .cells          = malloc(g_landmarks_count * sizeof(u32)),
+        .cell_count     = cell_count,
+        .connectivity   = grid->connectivity,
+        .revision       = grid->revision
+    };
+
+    u32 seed = grid->start;
+    for (u64 cell = 0; seed == GRID_NO_CELL && cell < cell_count; ++cell)
+    {
+        if (gridIsWall(grid, cell) == 0) seed = (u32)cell;
+    }
+
+    if (seed == GRID_NO_CELL) return;
+
+    u32 count = place_landmarks(grid, seed, g_landmarks.cells, g_landmarks.requested);
+
+    g_landmarks.count = count;
+    g_landmarks.from  = malloc(cell_count * count * sizeof(u32));
+    g_landmarks.to    = malloc(cell_count * count * sizeof(u32));
+
+    LandmarkBuild build = {
+        .grid       = grid,
+        .tables     = &g_landmarks,
+        .queue      = searchResolveQueue(SEARCH_QUEUE_AUTO, gridMaxStepCost(grid)),
+        .max_step   = (u32)gridMaxStepCost(grid),
+        .job_count  = 2 * count,
+        .next_job   = 0
+    };
+
+    u32 threads = searchGetThreads() > 0 ? searchGetThreads() : searchBatchDefaultThreads();
+    if (threads > build.job_count) threads = build.job_count;
+
+    // The calling thread takes jobs too
+    pthread_t* workers = malloc(threads * sizeof(pthread_t));
+    for (u32 i = 1; i < threads; ++i) pthread_create(&workers[i], NULL, build_worker, &build);
+    build_worker(&build);
+    for (u32 i = 1; i < threads; ++i) pthread_join(workers[i], NULL);
+    free(workers);
+
+    LOG_INFO("Built %u landmarks on %u threads in %.3f ms", count, threads, (timerNowNs() - begin) / 1e6);
+}
+
+void
+landmarksSetCount(u32 count)
+{
+    if (count == 0 || count > LANDMARKS_MAX_COUNT)
+    {
+        LOG_ERROR("Landmark count must be 1 to %u, not %u", LANDMARKS_MAX_COUNT, count);
+        return;
+    }
+
+    g_landmarks_count = count;
+}
+
+u32
+landmarksGetCount(void)
+{
+    return g_landmarks_count;
+}
+
+const LandmarkTables*
+landmarksPrepare(void)
+{
+    const Grid* grid = gridGet();
+
+    if (g_landmarks.cells == NULL || g_landmarks.cell_count != gridGetCellCount() ||
+        g_landmarks.revision != grid->revision || g_landmarks.connectivity != grid->connectivity ||
+        g_landmarks.requested != g_landmarks_count)
+    {
+        build_tables();
+    }
+
+    return &g_landmarks;
+}
+
+void
+landmarksDestroy(void)
+{
+    free(g_landmarks.cells);
+    free(g_landmarks.from);
+    free(g_landmarks.to);
+
+    g_landmarks = (LandmarkTables){0};
+}
+
+b8
+landmarksSave(const char* path)
+{
+    const LandmarkTables* tables  = landmarksPrepare();
+    const Grid*           grid    = gridGet();
+    u64                   entries = tables->cell_count * tables->count;
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL)
+    {
+        LOG_ERROR("Could not write landmarks: %s", path);
+        return 0;
+    }
+
+    LandmarkFileHeader header = {
+        .magic          = LANDMARKS_MAGIC,
+        .version        = LANDMARKS_VERSION,
+        .rows           = grid->rows,
+        .cols           = grid->cols,
+        .connectivity   = tables->connectivity,
+        .requested      = tables->requested,
+        .count          = tables->count,
+        .map_hash       = map_hash(grid)
+    };
+
+    b8 written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                 fwrite(tables->cells, sizeof(u32), tables->count, file) == tables->count &&
+                 fwrite(tables->from, sizeof(u32), entries, file) == entries &&
+                 fwrite(tables->to, sizeof(u32), entries, file) == entries;
+
+    if (fclose(file) != 0) written = 0;
+    if (written == 0) LOG_ERROR("Could not write landmarks: %s", path);
+
+    return written;
+}
+
+b8
+landmarksLoad(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        LOG_ERROR("Could not read landmarks: %s", path);
+        return 0;
+    }
+
+    const Grid*        grid = gridGet();
+    LandmarkFileHeader header;
+
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        header.magic != LANDMARKS_MAGIC || header.version != LANDMARKS_VERSION)
+    {
+        LOG_ERROR("Not a landmark file: %s", path);
+        fclose(file);
+        return 0;
+    }
+
+    if (header.rows != grid->rows || header.cols != grid->cols || header.connectivity != grid->connectivity ||
+        header.requested != g_landmarks_count || header.count > header.requested ||
+        header.map_hash != map_hash(grid))
+    {
+        LOG_INFO("%s was built for another map or landmark count", path);
+        fclose(file);
+        return 0;
+    }
+
+    landmarksDestroy();
+
+    u64 cell_count = gridGetCellCount();
+    u64 entries    = cell_count * header.count;
+
+    g_landmarks = (LandmarkTables){
+        .count          = header.count,
+        .requested      = header.requested,
+        .cells          = malloc(header.requested * sizeof(u32)),
+        .from           = malloc(entries * sizeof(u32)),
+        .to             = malloc(entries * sizeof(u32)),
+        .cell_count     = cell_count,
+        .connectivity   = grid->connectivity,
+        .revision       = grid->revision
+    };
+
+    b8 read = fread(g_landmarks.cells, sizeof(u32), header.count, file) == header.count &&
+              fread(g_landmarks.from, sizeof(u32), entries, file) == entries &&
+              fread(g_landmarks.to, sizeof(u32), entries, file) == entries;
+
+    fclose(file);
+
+    if (read == 0)
+    {
+        LOG_ERROR("Truncated landmark file: %s", path);
+        landmarksDestroy();
+        return 0;
+    }
+
+    return 1;
+}
+
+u64
+landmarksGetMemoryBytes(void)
+{
+    return g_landmarks.requested * sizeof(u32) + 2 * g_landmarks.cell_count * g_landmarks.count * sizeof(u32);
+}
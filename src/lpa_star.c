@@ -0,0 +1,323 @@
+#include "lpa_star.h"
+
+#include "logger.h"
+#include "ds/heap.h"
+
+#include "grid.h"
+#include "grid_neighbors.h"
+#include "search.h"
+
+#include <stdlib.h>
+
+// Keys are compared as [min(g, rhs) + h, min(g, rhs)]
+typedef struct LpaEntry
+{
+    u64     primary;
+    u32     secondary;
+    u32     cell;
+} LpaEntry;
+
+// The queue uses lazy deletion: an entry is current only while its cell is
+// inconsistent (g != rhs) and its key matches the cell's key
+static Heap     g_lpa_queue             = {0};
+static u64      g_lpa_queue_size        = 0;
+static u32*     g_lpa_rhs               = NULL;
+static u64      g_lpa_capacity          = 0;
+static u64      g_lpa_cell_count        = 0;
+static u32      g_lpa_epoch             = 0;
+static u32      g_lpa_start             = GRID_NO_CELL;
+static u32      g_lpa_goal              = GRID_NO_CELL;
+static b8       g_lpa_is_running        = 0;
+static b8       g_lpa_has_finished      = 0;
+
+// Cells this search marked visited, so a repair clears only those bits
+static u32*     g_lpa_marked            = NULL;
+static u64      g_lpa_marked_count      = 0;
+static u64      g_lpa_marked_capacity   = 0;
+
+static b8
+key_less(const LpaEntry* a, const LpaEntry* b)
+{
+    if (a->primary != b->primary) return a->primary < b->primary;
+
+    return a->secondary < b->secondary;
+}
+
+static b8
+lpa_comparator(void* a, void* b)
+{
+    return key_less((LpaEntry*)b, (LpaEntry*)a);
+}
+
+static LpaEntry
+calculate_key(const Grid* grid, u32 cell)
+{
+    u32 g    = grid->distance[cell];
+    u32 best = g < g_lpa_rhs[cell] ? g : g_lpa_rhs[cell];
+
+    LpaEntry entry = {
+        .primary    = best == GRID_INFINITY ? UINT64_MAX : (u64)best + gridManhattanDistance(grid, cell, g_lpa_goal),
+        .secondary  = best,
+        .cell       = cell
+    };
+
+    return entry;
+}
+
+// Best distance through any neighbor, entering a cell costs its weight
+static u32
+compute_rhs(const Grid* grid, u32 cell)
+{
+    if (cell == g_lpa_start)            return 0;
+    if (gridIsWall(grid, cell) == 1)    return GRID_INFINITY;
+
+    u32 neighbors[8];
+    u32 count = gridOpenNeighbors(grid, cell, GRID_CONNECT_4, neighbors, NULL);
+    u64 best  = GRID_INFINITY;
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        u32 g = gridGetDistance(grid, neighbors[i]);
+        if (g == GRID_INFINITY) continue;
+
+        u64 temp = (u64)g + grid->weight[cell];
+        if (temp < best) best = temp;
+    }
+
+    return (u32)best;
+}
+
+static void
+push(const Grid* grid, u32 cell)
+{
+    LpaEntry entry = calculate_key(grid, cell);
+
+    heapInsert(&g_lpa_queue, &entry);
+    g_lpa_queue_size += 1;
+    searchStatsQueuePush(searchGetStats(), g_lpa_queue_size);
+}
+
+// gridTouch() for rhs as well: rhs shares the grid's stamps, so a search only
+// resets the cells it reaches
+static void
+touch(Grid* grid, u32 cell)
+{
+    if (grid->stamp[cell] == grid->epoch) return;
+
+    g_lpa_rhs[cell] = GRID_INFINITY;
+    gridTouch(grid, cell);
+}
+
+static void
+update_vertex(Grid* grid, u32 cell)
+{
+    touch(grid, cell);
+
+    if (cell != g_lpa_start) g_lpa_rhs[cell] = compute_rhs(grid, cell);
+
+    if (grid->distance[cell] != g_lpa_rhs[cell]) push(grid, cell);
+}
+
+static void
+update_neighbors(Grid* grid, u32 cell)
+{
+    u32 neighbors[8];
+    u32 count = gridOpenNeighbors(grid, cell, GRID_CONNECT_4, neighbors, NULL);
+
+    for (u32 i = 0; i < count; ++i) update_vertex(grid, neighbors[i]);
+}
+
+static void
+mark_visited(Grid* grid, u32 cell)
+{
+    if (gridIsVisited(grid, cell) == 1) return;
+
+    if (g_lpa_marked_count == g_lpa_marked_capacity)
+    {
+        g_lpa_marked_capacity = g_lpa_marked_capacity == 0 ? 64 : 2 * g_lpa_marked_capacity;
+        g_lpa_marked          = realloc(g_lpa_marked, g_lpa_marked_capacity * sizeof(u32));
+    }
+
+    g_lpa_marked[g_lpa_marked_count++] = cell;
+    gridMarkVisited(grid, cell);
+}
+
+// Follows the neighbors with the smallest g back from the goal
+static void
+extract_path(Grid* grid)
+{
+    grid->parent[g_lpa_start] = GRID_NO_CELL;
+
+    u32 cell = g_lpa_goal;
+    while (cell != g_lpa_start)
+    {
+        u32 neighbors[8];
+        u32 count = gridOpenNeighbors(grid, cell, GRID_CONNECT_4, neighbors, NULL);
+        u32 best  = GRID_NO_CELL;
+
+        for (u32 i = 0; i < count; ++i)
+        {
+            u32 neighbor = neighbors[i];
+            if (best == GRID_NO_CELL || gridGetDistance(grid, neighbor) < gridGetDistance(grid, best)) best = neighbor;
+        }
+
+        grid->parent[cell] = best;
+        cell               = best;
+    }
+}
+
+static void
+finish(Grid* grid)
+{
+    if (grid->distance[g_lpa_goal] != GRID_INFINITY)
+    {
+        LOG_INFO("Found path!");
+        LOG_INFO("Distance %u", grid->distance[g_lpa_goal]);
+
+        extract_path(grid);
+        mark_visited(grid, g_lpa_goal);
+    }
+    else
+    {
+        LOG_INFO("Could not find path!");
+        gridBitClear(grid->visited, g_lpa_goal);
+    }
+
+    g_lpa_is_running    = 0;
+    g_lpa_has_finished  = 1;
+}
+
+void
+lpaStarInit(u64 capacity)
+{
+    Grid* grid = gridGet();
+
+    if (g_lpa_rhs != NULL) heapDestroy(&g_lpa_queue);
+
+    // rhs is kept between searches, like the grid's own arrays
+    if (gridGetCellCount() != g_lpa_cell_count)
+    {
+        g_lpa_cell_count = gridGetCellCount();
+        g_lpa_rhs        = realloc(g_lpa_rhs, g_lpa_cell_count * sizeof(u32));
+    }
+
+    g_lpa_capacity   = capacity;
+    g_lpa_start      = grid->start;
+    g_lpa_goal       = grid->goal;
+    g_lpa_epoch      = grid->epoch;
+    g_lpa_queue      = heapCreate(sizeof(LpaEntry), capacity, lpa_comparator);
+    g_lpa_queue_size = 0;
+
+    // gridReset() cleared the visited bits before this search
+    g_lpa_marked_count = 0;
+
+    // g lives in grid->distance. Neighbors the search never touched read as
+    // GRID_INFINITY through gridGetDistance(), the goal's key is read every step.
+    touch(grid, g_lpa_goal);
+    touch(grid, g_lpa_start);
+
+    g_lpa_rhs[g_lpa_start] = 0;
+    push(grid, g_lpa_start);
+
+    g_lpa_is_running    = 1;
+    g_lpa_has_finished  = 0;
+}
+
+void
+lpaStarStep(void)
+{
+    if (g_lpa_is_running == 0 || g_lpa_has_finished == 1) return;
+
+    Grid*        grid  = gridGet();
+    SearchStats* stats = searchGetStats();
+
+    if (heapIsEmpty(&g_lpa_queue) == WIM_TRUE)
+    {
+        finish(grid);
+        return;
+    }
+
+    LpaEntry entry;
+    heapExtract(&g_lpa_queue, &entry);
+    g_lpa_queue_size -= 1;
+    searchStatsPop(stats);
+
+    u32      cell    = entry.cell;
+    LpaEntry current = calculate_key(grid, cell);
+
+    if (grid->distance[cell] == g_lpa_rhs[cell] || key_less(&entry, &current) || key_less(&current, &entry))
+    {
+        stats->stale_pops += 1;
+        return;
+    }
+
+    // Done once nothing left in the queue can lower the goal's distance
+    LpaEntry goal_key = calculate_key(grid, g_lpa_goal);
+    if (key_less(&entry, &goal_key) == 0 && grid->distance[g_lpa_goal] == g_lpa_rhs[g_lpa_goal])
+    {
+        heapInsert(&g_lpa_queue, &entry);
+        g_lpa_queue_size += 1;
+        searchStatsPush(stats);
+
+        finish(grid);
+        return;
+    }
+
+    mark_visited(grid, cell);
+    stats->expanded += 1;
+
+    if (grid->distance[cell] > g_lpa_rhs[cell])
+    {
+        // Overconsistent: the distance went down, settle it
+        grid->distance[cell] = g_lpa_rhs[cell];
+    }
+    else
+    {
+        // Underconsistent: the distance went up, start over from rhs
+        grid->distance[cell] = GRID_INFINITY;
+        update_vertex(grid, cell);
+    }
+
+    update_neighbors(grid, cell);
+}
+
+b8
+lpaStarShouldStop(void)
+{
+    return (g_lpa_is_running == 0) && (g_lpa_has_finished == 1);
+}
+
+void
+lpaStarCellChanged(u32 cell)
+{
+    if (g_lpa_rhs == NULL) return;
+
+    Grid* grid = gridGet();
+
+    // Keys depend on the start and the goal, moving either one means planning
+    // from scratch. So does a gridReset() since the plan, it made g and rhs stale.
+    if (grid->start != g_lpa_start || grid->goal != g_lpa_goal || grid->epoch != g_lpa_epoch)
+    {
+        gridReset();
+
+        if (grid->start == GRID_NO_CELL || grid->goal == GRID_NO_CELL)
+        {
+            g_lpa_is_running    = 0;
+            g_lpa_has_finished  = 1;
+            return;
+        }
+
+        lpaStarInit(g_lpa_capacity);
+        return;
+    }
+
+    // Only show the cells processed by this repair
+    for (u64 i = 0; i < g_lpa_marked_count; ++i) gridBitClear(grid->visited, g_lpa_marked[i]);
+    g_lpa_marked_count = 0;
+
+    update_vertex(grid, cell);
+    update_neighbors(grid, cell);
+
+    g_lpa_is_running    = 1;
+    g_lpa_has_finished  = 0;
+}
@@ -2,7 +2,9 @@
 #include "raylib.h"
 
 #include "grid.h"
+#include "grid_view.h"
 #include "animate.h"
+#include "map_io.h"
 
 #define WINDOW_WIDTH    1200
 #define WINDOW_HEIGHT   800
@@ -12,7 +14,7 @@
 #define GRID_ROWS 20
 #define GRID_COLS 32
 
-int main(void)
+int main(int argc, char** argv)
 {
     LoggerConfig config = getDefaultLoggerConfig();
     config.out = LOG_OUTPUT_CONSOLE;
@@ -23,7 +25,9 @@ int main(void)
     LOG_DEBUG("Raylib window initialized!");
     SetTargetFPS(WINDOW_FPS);
 
-    gridCreate(WINDOW_WIDTH, WINDOW_HEIGHT, GRID_ROWS, GRID_COLS);
+    // An optional map to open, in any format mapLoadAny() knows
+    if (argc < 2 || mapLoadAny(argv[1]) == 0) gridCreate(GRID_ROWS, GRID_COLS);
+    gridViewCreate(WINDOW_WIDTH, WINDOW_HEIGHT);
     LOG_DEBUG("Grid created!");
 
     while(!WindowShouldClose())
@@ -36,6 +40,7 @@ int main(void)
         BeginDrawing();
         ClearBackground(BLACK);
         DrawFPS(0, 0);
+        gridDrawStats();
 
         // Render
         gridDraw();
@@ -44,6 +49,7 @@ int main(void)
     }
 
     LOG_DEBUG("Grid destruction...");
+    gridViewDestroy();
     gridDestroy();
 
     LOG_DEBUG("Raylib window closing...");
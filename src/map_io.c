@@ -0,0 +1,505 @@
+#include "map_io.h"
+
+#include "logger.h"
+
+#include "grid.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// "PFMP" when read as a little-endian u32
+#define MAP_BINARY_MAGIC    0x504D4650u
+#define MAP_BINARY_VERSION  1
+
+// Followed by the wall bitset (one u64 per 64 cells) and one u32 weight per
+// cell, the header size keeps both aligned once mapped
+typedef struct MapBinaryHeader
+{
+    u32     magic;
+    u32     version;
+    u32     rows;
+    u32     cols;
+    u32     start;
+    u32     goal;
+    u32     max_weight;
+    u32     reserved;
+} MapBinaryHeader;
+
+static char*
+read_file(const char* path, u64* size)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) return NULL;
+
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    if (length < 0)
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    char* buffer = malloc((u64)length + 1);
+    if (buffer == NULL)
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    *size = fread(buffer, 1, (u64)length, file);
+    buffer[*size] = '\0';
+
+    fclose(file);
+    return buffer;
+}
+
+b8
+mapLoad(const char* path)
+{
+    u64   size = 0;
+    char* text = read_file(path, &size);
+    if (text == NULL)
+    {
+        LOG_ERROR("Could not read map: %s", path);
+        return 0;
+    }
+
+    // First pass: measure the map and validate that every row has the same width
+    u64 rows = 0;
+    u64 cols = 0;
+    for (char* line = strtok(text, "\r\n"); line != NULL; line = strtok(NULL, "\r\n"))
+    {
+        u64 width = strlen(line);
+        if (rows == 0) cols = width;
+
+        if (width != cols)
+        {
+            LOG_ERROR("Map row %lu has %lu cells, expected %lu", rows, width, cols);
+            free(text);
+            return 0;
+        }
+
+        rows += 1;
+    }
+
+    if (rows == 0 || cols == 0 || rows * cols > GRID_MAX_CELLS)
+    {
+        LOG_ERROR("Map must have between 1 and %u cells", GRID_MAX_CELLS);
+        free(text);
+        return 0;
+    }
+
+    // The map is valid, only now replace the grid
+    gridDestroy();
+    gridCreate(rows, cols);
+
+    // Second pass: strtok left a '\0' after every row, so rows are laid out back to back
+    char* line = text;
+    for (u64 row = 0; row < rows; ++row)
+    {
+        while (*line == '\0' || *line == '\r' || *line == '\n') ++line;
+
+        for (u64 col = 0; col < cols; ++col)
+        {
+            char symbol = line[col];
+
+            if      (symbol == '#' || symbol == '@')    gridSetWall(row, col, 1);
+            else if (symbol == 'S')                     gridSetStart(row, col);
+            else if (symbol == 'G')                     gridSetGoal(row, col);
+            else if (symbol >= '1' && symbol <= '9')    gridSetWeight(row, col, symbol - '0');
+        }
+
+        line += cols;
+    }
+
+    free(text);
+    return 1;
+}
+
+// Cuts the next line out of the text, returns NULL at the end
+static char*
+next_line(char** cursor)
+{
+    char* line = *cursor;
+    if (*line == '\0') return NULL;
+
+    char* end = strchr(line, '\n');
+    if (end != NULL)
+    {
+        *end    = '\0';
+        *cursor = end + 1;
+    }
+    else
+    {
+        *cursor = line + strlen(line);
+    }
+
+    u64 length = strlen(line);
+    if (length > 0 && line[length - 1] == '\r') line[length - 1] = '\0';
+
+    return line;
+}
+
+static const char*
+extension(const char* path)
+{
+    const char* dot   = strrchr(path, '.');
+    const char* slash = strrchr(path, '/');
+
+    return dot != NULL && (slash == NULL || dot > slash) ? dot : "";
+}
+
+b8
+mapSave(const char* path)
+{
+    Grid* grid = gridGet();
+
+    FILE* file = fopen(path, "w");
+    if (file == NULL)
+    {
+        LOG_ERROR("Could not write map: %s", path);
+        return 0;
+    }
+
+    char* line = malloc((u64)grid->cols + 1);
+    line[grid->cols] = '\n';
+
+    for (u32 row = 0; row < grid->rows; ++row)
+    {
+        for (u32 col = 0; col < grid->cols; ++col)
+        {
+            u32 cell   = gridGetCell(row, col);
+            u32 weight = grid->weight[cell] < 9 ? grid->weight[cell] : 9;
+
+            if      (cell == grid->start)           line[col] = 'S';
+            else if (cell == grid->goal)            line[col] = 'G';
+            else if (gridIsWall(grid, cell) == 1)   line[col] = '#';
+            else if (weight > 1)                    line[col] = '0' + weight;
+            else                                    line[col] = '.';
+        }
+
+        fwrite(line, 1, (u64)grid->cols + 1, file);
+    }
+
+    free(line);
+    fclose(file);
+
+    return 1;
+}
+
+b8
+mapLoadMovingAi(const char* path)
+{
+    u64   size = 0;
+    char* text = read_file(path, &size);
+    if (text == NULL)
+    {
+        LOG_ERROR("Could not read map: %s", path);
+        return 0;
+    }
+
+    // Header: "type octile", "height <rows>", "width <cols>" and "map"
+    char* cursor  = text;
+    char* line    = NULL;
+    u32   rows    = 0;
+    u32   cols    = 0;
+    b8    has_map = 0;
+
+    while (has_map == 0 && (line = next_line(&cursor)) != NULL)
+    {
+        if      (sscanf(line, "height %u", &rows) == 1) continue;
+        else if (sscanf(line, "width %u", &cols) == 1)  continue;
+        else if (strcmp(line, "map") == 0)              has_map = 1;
+    }
+
+    if (has_map == 0 || rows == 0 || cols == 0 || (u64)rows * cols > GRID_MAX_CELLS)
+    {
+        LOG_ERROR("Not a MovingAI map or bad dimensions: %s", path);
+        free(text);
+        return 0;
+    }
+
+    // Every row is checked before the grid is touched, a bad file keeps the current map
+    char** lines = malloc(rows * sizeof(char*));
+    for (u32 row = 0; row < rows; ++row)
+    {
+        lines[row] = next_line(&cursor);
+        if (lines[row] == NULL || strlen(lines[row]) < cols)
+        {
+            LOG_ERROR("Map row %u is shorter than %u cells", row, cols);
+            free(lines);
+            free(text);
+            return 0;
+        }
+    }
+
+    gridDestroy();
+    gridCreate(rows, cols);
+
+    // Trees, water and out of bounds terrain cannot be crossed from open ground
+    for (u32 row = 0; row < rows; ++row)
+    {
+        for (u32 col = 0; col < cols; ++col)
+        {
+            char symbol = lines[row][col];
+            if (symbol != '.' && symbol != 'G' && symbol != 'S') gridSetWall(row, col, 1);
+        }
+    }
+
+    free(lines);
+    free(text);
+    return 1;
+}
+
+b8
+mapSaveMovingAi(const char* path)
+{
+    Grid* grid = gridGet();
+
+    FILE* file = fopen(path, "w");
+    if (file == NULL)
+    {
+        LOG_ERROR("Could not write map: %s", path);
+        return 0;
+    }
+
+    fprintf(file, "type octile\nheight %u\nwidth %u\nmap\n", grid->rows, grid->cols);
+
+    char* line = malloc((u64)grid->cols + 1);
+    line[grid->cols] = '\n';
+
+    for (u32 row = 0; row < grid->rows; ++row)
+    {
+        for (u32 col = 0; col < grid->cols; ++col)
+        {
+            line[col] = gridIsWall(grid, gridGetCell(row, col)) == 1 ? '@' : '.';
+        }
+
+        fwrite(line, 1, (u64)grid->cols + 1, file);
+    }
+
+    free(line);
+    fclose(file);
+
+    return 1;
+}
+
+b8
+mapLoadBinary(const char* path)
+{
+    int descriptor = open(path, O_RDONLY);
+    if (descriptor < 0)
+    {
+        LOG_ERROR("Could not read map: %s", path);
+        return 0;
+    }
+
+    struct stat info;
+    if (fstat(descriptor, &info) != 0 || (u64)info.st_size < sizeof(MapBinaryHeader))
+    {
+        LOG_ERROR("Not a binary map: %s", path);
+        close(descriptor);
+        return 0;
+    }
+
+    // Private mapping: edits made in the editor never reach the file
+    u64   size    = info.st_size;
+    void* mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+
+    if (mapping == MAP_FAILED)
+    {
+        LOG_ERROR("Could not map %s", path);
+        return 0;
+    }
+
+    const MapBinaryHeader* header     = mapping;
+    u64                    cell_count = (u64)header->rows * header->cols;
+    u64                    word_count = (cell_count + 63) / 64;
+
+    if (header->magic != MAP_BINARY_MAGIC || header->version != MAP_BINARY_VERSION ||
+        cell_count == 0 || cell_count > GRID_MAX_CELLS ||
+        size != sizeof(MapBinaryHeader) + word_count * sizeof(u64) + cell_count * sizeof(u32))
+    {
+        LOG_ERROR("Not a binary map or truncated: %s", path);
+        munmap(mapping, size);
+        return 0;
+    }
+
+    u64* wall   = (u64*)((u8*)mapping + sizeof(MapBinaryHeader));
+    u32* weight = (u32*)(wall + word_count);
+
+    // The searches trust max_weight to bound every step and never expect a free
+    // cell, so the weights are checked once here rather than on every
+    // expansion. The header's max_weight is not trusted, the grid gets the
+    // largest weight actually stored.
+    u32 max_weight = 1;
+    for (u64 i = 0; i < cell_count; ++i)
+    {
+        if (weight[i] == 0 || weight[i] > GRID_MAX_WEIGHT)
+        {
+            LOG_ERROR("Cell %lu of %s has weight %u, outside 1..%u", i, path, weight[i], GRID_MAX_WEIGHT);
+            munmap(mapping, size);
+            return 0;
+        }
+
+        if (weight[i] > max_weight) max_weight = weight[i];
+    }
+
+    u32 rows  = header->rows;
+    u32 cols  = header->cols;
+    u32 start = header->start;
+    u32 goal  = header->goal;
+
+    gridDestroy();
+    gridCreateMapped(rows, cols, weight, wall, max_weight, mapping, size);
+
+    if (start < cell_count) gridSetStart(start / cols, start % cols);
+    if (goal  < cell_count) gridSetGoal(goal / cols, goal % cols);
+
+    return 1;
+}
+
+b8
+mapSaveBinary(const char* path)
+{
+    Grid* grid       = gridGet();
+    u64   cell_count = gridGetCellCount();
+    u64   word_count = (cell_count + 63) / 64;
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL)
+    {
+        LOG_ERROR("Could not write map: %s", path);
+        return 0;
+    }
+
+    MapBinaryHeader header = {
+        .magic      = MAP_BINARY_MAGIC,
+        .version    = MAP_BINARY_VERSION,
+        .rows       = grid->rows,
+        .cols       = grid->cols,
+        .start      = grid->start,
+        .goal       = grid->goal,
+        .max_weight = grid->max_weight
+    };
+
+    b8 written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                 fwrite(grid->wall, sizeof(u64), word_count, file) == word_count &&
+                 fwrite(grid->weight, sizeof(u32), cell_count, file) == cell_count;
+
+    if (fclose(file) != 0) written = 0;
+    if (written == 0) LOG_ERROR("Could not write map: %s", path);
+
+    return written;
+}
+
+b8
+mapLoadAny(const char* path)
+{
+    const char* ext = extension(path);
+
+    if (strcmp(ext, ".map") == 0)   return mapLoadMovingAi(path);
+    if (strcmp(ext, ".pfmap") == 0) return mapLoadBinary(path);
+
+    return mapLoad(path);
+}
+
+b8
+mapSaveAny(const char* path)
+{
+    const char* ext = extension(path);
+
+    if (strcmp(ext, ".map") == 0)   return mapSaveMovingAi(path);
+    if (strcmp(ext, ".pfmap") == 0) return mapSaveBinary(path);
+
+    return mapSave(path);
+}
+
+b8
+scenarioLoad(const char* path, Scenario* scenario)
+{
+    *scenario = (Scenario){0};
+
+    u64   size = 0;
+    char* text = read_file(path, &size);
+    if (text == NULL)
+    {
+        LOG_ERROR("Could not read scenario: %s", path);
+        return 0;
+    }
+
+    char* cursor   = text;
+    char* line     = NULL;
+    u64   capacity = 0;
+
+    while ((line = next_line(&cursor)) != NULL)
+    {
+        if (strncmp(line, "version", 7) == 0 || line[0] == '\0') continue;
+
+        ScenarioEntry entry;
+        char          map_name[256];
+
+        if (sscanf(line, "%u %255s %u %u %u %u %u %u %lf", &entry.bucket, map_name,
+                   &entry.map_width, &entry.map_height, &entry.start_x, &entry.start_y,
+                   &entry.goal_x, &entry.goal_y, &entry.optimal_length) != 9)
+        {
+            LOG_ERROR("Bad scenario line %lu in %s", scenario->count + 1, path);
+            scenarioDestroy(scenario);
+            free(text);
+            return 0;
+        }
+
+        if (scenario->count == 0) strcpy(scenario->map_name, map_name);
+
+        if (scenario->count == capacity)
+        {
+            capacity          = capacity > 0 ? capacity * 2 : 256;
+            scenario->entries = realloc(scenario->entries, capacity * sizeof(ScenarioEntry));
+        }
+
+        scenario->entries[scenario->count++] = entry;
+    }
+
+    free(text);
+    return 1;
+}
+
+b8
+scenarioSave(const char* path, const Scenario* scenario)
+{
+    FILE* file = fopen(path, "w");
+    if (file == NULL)
+    {
+        LOG_ERROR("Could not write scenario: %s", path);
+        return 0;
+    }
+
+    fprintf(file, "version 1\n");
+
+    for (u64 i = 0; i < scenario->count; ++i)
+    {
+        const ScenarioEntry* entry = &scenario->entries[i];
+
+        fprintf(file, "%u\t%s\t%u\t%u\t%u\t%u\t%u\t%u\t%.8f\n", entry->bucket, scenario->map_name,
+                entry->map_width, entry->map_height, entry->start_x, entry->start_y,
+                entry->goal_x, entry->goal_y, entry->optimal_length);
+    }
+
+    fclose(file);
+    return 1;
+}
+
+void
+scenarioDestroy(Scenario* scenario)
+{
+    free(scenario->entries);
+    *scenario = (Scenario){0};
+}
@@ -0,0 +1,368 @@
+#include "priority_queue.h"
+
+#include "grid.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define PQ_RADIX_BUCKETS    33
+#define PQ_DARY_ARITY       4
+
+static const char* g_pq_names[PQ_COUNT] = {
+    [PQ_BINARY_HEAP]    = "heap",
+    [PQ_BUCKET]         = "bucket",
+    [PQ_RADIX]          = "radix",
+    [PQ_DARY]           = "dary"
+};
+
+static b8
+binary_heap_comparator(void* a, void* b)
+{
+    PQEntry* entry_a = (PQEntry*)a;
+    PQEntry* entry_b = (PQEntry*)b;
+
+    return entry_b->priority < entry_a->priority;
+}
+
+static void
+bucket_push(PQBucket* bucket, PQEntry entry)
+{
+    if (bucket->size == bucket->capacity)
+    {
+        bucket->capacity = bucket->capacity > 0 ? bucket->capacity * 2 : 16;
+        bucket->entries  = realloc(bucket->entries, bucket->capacity * sizeof(PQEntry));
+    }
+
+    bucket->entries[bucket->size++] = entry;
+}
+
+// ---------------------------------------------------------------------------
+// Radix heap
+// ---------------------------------------------------------------------------
+
+// 0 for a key equal to the last popped one, otherwise 1 + the index of the
+// highest bit in which they differ
+static u32
+radix_bucket(u32 key, u32 last)
+{
+    u32 diff = key ^ last;
+    if (diff == 0) return 0;
+
+#if defined(__GNUC__) || defined(__clang__)
+    return 32 - __builtin_clz(diff);
+#else
+    u32 bucket = 0;
+    while (diff != 0) { diff >>= 1; ++bucket; }
+    return bucket;
+#endif
+}
+
+static void
+radix_pop(PriorityQueue* queue, PQEntry* entry)
+{
+    PQBucket* buckets = queue->buckets;
+
+    if (buckets[0].size == 0)
+    {
+        u32 index = 1;
+        while (buckets[index].size == 0) ++index;
+
+        // The smallest key of the first non-empty bucket becomes the new base;
+        // every entry of that bucket then moves to a strictly lower bucket
+        PQBucket* bucket = &buckets[index];
+        u32       min    = bucket->entries[0].priority;
+        for (u32 i = 1; i < bucket->size; ++i)
+        {
+            if (bucket->entries[i].priority < min) min = bucket->entries[i].priority;
+        }
+
+        queue->cursor = min;
+
+        for (u32 i = 0; i < bucket->size; ++i)
+        {
+            PQEntry moved = bucket->entries[i];
+            bucket_push(&buckets[radix_bucket(moved.priority, min)], moved);
+        }
+
+        bucket->size = 0;
+    }
+
+    *entry = buckets[0].entries[--buckets[0].size];
+}
+
+// ---------------------------------------------------------------------------
+// Indexed d-ary heap
+// ---------------------------------------------------------------------------
+
+static void
+dary_place(PriorityQueue* queue, u64 slot, PQEntry entry)
+{
+    queue->nodes[slot]              = entry;
+    queue->position[entry.cell]     = slot;
+}
+
+static void
+dary_sift_up(PriorityQueue* queue, u64 slot)
+{
+    PQEntry entry = queue->nodes[slot];
+
+    while (slot > 0)
+    {
+        u64 parent = (slot - 1) / PQ_DARY_ARITY;
+        if (queue->nodes[parent].priority <= entry.priority) break;
+
+        dary_place(queue, slot, queue->nodes[parent]);
+        slot = parent;
+    }
+
+    dary_place(queue, slot, entry);
+}
+
+static void
+dary_sift_down(PriorityQueue* queue, u64 slot)
+{
+    PQEntry entry = queue->nodes[slot];
+
+    for (;;)
+    {
+        u64 first = slot * PQ_DARY_ARITY + 1;
+        if (first >= queue->size) break;
+
+        u64 last = first + PQ_DARY_ARITY;
+        if (last > queue->size) last = queue->size;
+
+        u64 best = first;
+        for (u64 child = first + 1; child < last; ++child)
+        {
+            if (queue->nodes[child].priority < queue->nodes[best].priority) best = child;
+        }
+
+        if (queue->nodes[best].priority >= entry.priority) break;
+
+        dary_place(queue, slot, queue->nodes[best]);
+        slot = best;
+    }
+
+    dary_place(queue, slot, entry);
+}
+
+static void
+dary_push(PriorityQueue* queue, u32 cell, u32 priority)
+{
+    u32 slot = queue->position[cell];
+
+    if (slot != GRID_NO_CELL)
+    {
+        if (priority >= queue->nodes[slot].priority) return;
+
+        queue->nodes[slot].priority = priority;
+        dary_sift_up(queue, slot);
+        return;
+    }
+
+    queue->nodes[queue->size] = (PQEntry){ .priority = priority, .cell = cell };
+    queue->size += 1;
+    dary_sift_up(queue, queue->size - 1);
+}
+
+static void
+dary_pop(PriorityQueue* queue, PQEntry* entry)
+{
+    *entry = queue->nodes[0];
+    queue->position[entry->cell] = GRID_NO_CELL;
+
+    queue->size -= 1;
+    if (queue->size == 0) return;
+
+    queue->nodes[0] = queue->nodes[queue->size];
+    dary_sift_down(queue, 0);
+}
+
+// ---------------------------------------------------------------------------
+
+PriorityQueue
+pqCreate(PriorityQueueKind kind, u64 capacity, u32 max_key_step)
+{
+    PriorityQueue queue = { .kind = kind };
+
+    switch (kind)
+    {
+        case PQ_BINARY_HEAP:
+            queue.heap = heapCreate(sizeof(PQEntry), capacity, binary_heap_comparator);
+            break;
+
+        case PQ_BUCKET:
+            queue.bucket_count  = max_key_step + 1;
+            queue.buckets       = calloc(queue.bucket_count, sizeof(PQBucket));
+            queue.cursor        = UINT32_MAX;
+            break;
+
+        case PQ_RADIX:
+            queue.bucket_count  = PQ_RADIX_BUCKETS;
+            queue.buckets       = calloc(queue.bucket_count, sizeof(PQBucket));
+            break;
+
+        case PQ_DARY:
+            queue.nodes     = malloc(capacity * sizeof(PQEntry));
+            queue.position  = malloc(capacity * sizeof(u32));
+            memset(queue.position, 0xFF, capacity * sizeof(u32));
+            break;
+
+        default:
+            break;
+    }
+
+    return queue;
+}
+
+void
+pqDestroy(PriorityQueue* queue)
+{
+    switch (queue->kind)
+    {
+        case PQ_BINARY_HEAP:
+            heapDestroy(&queue->heap);
+            break;
+
+        case PQ_BUCKET:
+        case PQ_RADIX:
+            for (u32 i = 0; i < queue->bucket_count; ++i) free(queue->buckets[i].entries);
+            free(queue->buckets);
+            break;
+
+        case PQ_DARY:
+            free(queue->nodes);
+            free(queue->position);
+            break;
+
+        default:
+            break;
+    }
+
+    *queue = (PriorityQueue){0};
+}
+
+void
+pqClear(PriorityQueue* queue)
+{
+    switch (queue->kind)
+    {
+        case PQ_BINARY_HEAP:
+        {
+            PQEntry entry;
+            while (heapIsEmpty(&queue->heap) != WIM_TRUE) heapExtract(&queue->heap, &entry);
+            break;
+        }
+
+        case PQ_BUCKET:
+        case PQ_RADIX:
+            for (u32 i = 0; i < queue->bucket_count; ++i) queue->buckets[i].size = 0;
+            queue->cursor = queue->kind == PQ_BUCKET ? UINT32_MAX : 0;
+            break;
+
+        case PQ_DARY:
+            for (u64 i = 0; i < queue->size; ++i) queue->position[queue->nodes[i].cell] = GRID_NO_CELL;
+            break;
+
+        default:
+            break;
+    }
+
+    queue->size = 0;
+}
+
+void
+pqPush(PriorityQueue* queue, u32 cell, u32 priority)
+{
+    PQEntry entry = { .priority = priority, .cell = cell };
+
+    switch (queue->kind)
+    {
+        case PQ_BINARY_HEAP:
+            heapInsert(&queue->heap, &entry);
+            queue->size += 1;
+            break;
+
+        case PQ_BUCKET:
+            // Only keys pushed before the first pop can be below the cursor
+            if (priority < queue->cursor) queue->cursor = priority;
+            bucket_push(&queue->buckets[priority % queue->bucket_count], entry);
+            queue->size += 1;
+            break;
+
+        case PQ_RADIX:
+            bucket_push(&queue->buckets[radix_bucket(priority, queue->cursor)], entry);
+            queue->size += 1;
+            break;
+
+        case PQ_DARY:
+            dary_push(queue, cell, priority);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void
+pqPop(PriorityQueue* queue, PQEntry* entry)
+{
+    switch (queue->kind)
+    {
+        case PQ_BINARY_HEAP:
+            heapExtract(&queue->heap, entry);
+            queue->size -= 1;
+            break;
+
+        case PQ_BUCKET:
+        {
+            PQBucket* bucket = &queue->buckets[queue->cursor % queue->bucket_count];
+            while (bucket->size == 0)
+            {
+                queue->cursor += 1;
+                bucket = &queue->buckets[queue->cursor % queue->bucket_count];
+            }
+
+            *entry = bucket->entries[--bucket->size];
+            queue->size -= 1;
+            break;
+        }
+
+        case PQ_RADIX:
+            radix_pop(queue, entry);
+            queue->size -= 1;
+            break;
+
+        case PQ_DARY:
+            dary_pop(queue, entry);
+            break;
+
+        default:
+            break;
+    }
+}
+
+b8
+pqIsEmpty(const PriorityQueue* queue)
+{
+    return queue->size == 0;
+}
+
+const char*
+pqKindName(PriorityQueueKind kind)
+{
+    if (kind >= PQ_COUNT) return "unknown";
+
+    return g_pq_names[kind];
+}
+
+PriorityQueueKind
+pqKindFromName(const char* name)
+{
+    for (u32 kind = 0; kind < PQ_COUNT; ++kind)
+    {
+        if (strcmp(name, g_pq_names[kind]) == 0) return (PriorityQueueKind)kind;
+    }
+
+    return PQ_COUNT;
+}
@@ -0,0 +1,386 @@
+#include "search.h"
+
+#include "logger.h"
+
+#include "grid.h"
+#include "grid_neighbors.h"
+#include "timer.h"
+#include "trace.h"
+
+#include "bfs.h"
+#include "dfs.h"
+#include "dijkstra.h"
+#include "a_star.h"
+#include "jps.h"
+#include "bidirectional.h"
+#include "lpa_star.h"
+#include "hpa.h"
+#include "bfs_parallel.h"
+#include "delta_stepping.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Dial's buckets need one bucket per possible key step
+#define SEARCH_MAX_BUCKET_WEIGHT 1024
+// Largest step an explicit bucket request gets, a ring of 4M buckets is 64 MB
+#define SEARCH_MAX_BUCKET_RING   (1u << 22)
+
+// Steps between two clock reads in searchStepFor()
+#define SEARCH_CLOCK_INTERVAL 64
+
+static SearchAlgo        g_active_algo       = ALGO_NONE;
+static SearchStats       g_search_stats      = {0};
+static PriorityQueueKind g_search_queue      = SEARCH_QUEUE_AUTO;
+static u64               g_search_init_ns    = 0;
+static u64               g_search_step_ns    = 0;
+static u32               g_search_threads    = 0;
+static u32               g_search_delta      = 0;
+
+static const char* g_algo_names[ALGO_COUNT] = {
+    [ALGO_NONE]           = "none",
+    [ALGO_BFS]            = "bfs",
+    [ALGO_DFS]            = "dfs",
+    [ALGO_DIJKSTRA]       = "dijkstra",
+    [ALGO_ASTAR]          = "astar",
+    [ALGO_JPS]            = "jps",
+    [ALGO_JPS_PLUS]       = "jps+",
+    [ALGO_BFS_BIDIR]      = "bfs-bi",
+    [ALGO_DIJKSTRA_BIDIR] = "dijkstra-bi",
+    [ALGO_ASTAR_BIDIR]    = "astar-bi",
+    [ALGO_LPA_STAR]       = "lpastar",
+    [ALGO_HPA]            = "hpa",
+    [ALGO_BFS_PARALLEL]   = "bfs-par",
+    [ALGO_DELTA_STEPPING] = "delta",
+    [ALGO_ASTAR_ALT]      = "astar-alt"
+};
+
+void
+searchInit(SearchAlgo algo)
+{
+    u64 begin = timerNowNs();
+
+    g_active_algo  = algo;
+    g_search_stats = (SearchStats){0};
+
+    u64 capacity = gridGetCellCount();
+
+    PriorityQueueKind queue = searchResolveQueue(g_search_queue, gridMaxStepCost(gridGet()));
+
+    // Every search reads the open moves of a cell from the mask, built once
+    // per wall layout
+    gridBuildMoves();
+
+    SearchAlgo resolved = searchResolveAlgo(algo);
+    if (resolved != algo)
+    {
+        LOG_INFO("%s grid, running %s instead of %s",
+                 gridGet()->connectivity == GRID_CONNECT_8 ? "8-connected" : "Weighted",
+                 g_algo_names[resolved], g_algo_names[algo]);
+        algo          = resolved;
+        g_active_algo = resolved;
+    }
+
+    if (TRACE_ENABLED == 1) traceBegin(algo);
+
+    switch (algo)
+    {
+        case ALGO_BFS:            bfsInit(capacity);                          break;
+        case ALGO_DFS:            dfsInit(capacity);                          break;
+        case ALGO_DIJKSTRA:       dijkstraInit(capacity, queue);              break;
+        case ALGO_ASTAR:          aStarInit(capacity, queue, 0);              break;
+        case ALGO_ASTAR_ALT:      aStarInit(capacity, queue, 1);              break;
+        case ALGO_JPS:            jpsInit(capacity, queue, 0);                break;
+        case ALGO_JPS_PLUS:       jpsInit(capacity, queue, 1);                break;
+        case ALGO_BFS_BIDIR:      bidirInit(ALGO_BFS, capacity, queue);       break;
+        case ALGO_DIJKSTRA_BIDIR: bidirInit(ALGO_DIJKSTRA, capacity, queue);  break;
+        case ALGO_ASTAR_BIDIR:    bidirInit(ALGO_ASTAR, capacity, queue);     break;
+        case ALGO_LPA_STAR:       lpaStarInit(capacity);                      break;
+        case ALGO_HPA:            hpaInit(capacity, queue);                   break;
+        case ALGO_BFS_PARALLEL:   bfsParallelInit(g_search_threads);          break;
+        case ALGO_DELTA_STEPPING: deltaSteppingInit(g_search_delta, g_search_threads); break;
+        default:                  g_active_algo = ALGO_NONE;                  break;
+    }
+
+    g_search_init_ns = timerNowNs() - begin;
+    g_search_step_ns = 0;
+}
+
+void
+searchStep(void)
+{
+    switch (g_active_algo)
+    {
+        case ALGO_BFS:            bfsStep();                                  break;
+        case ALGO_DFS:            dfsStep();                                  break;
+        case ALGO_DIJKSTRA:       dijkstraStep();                             break;
+        case ALGO_ASTAR:
+        case ALGO_ASTAR_ALT:      aStarStep();                                break;
+        case ALGO_JPS:
+        case ALGO_JPS_PLUS:       jpsStep();                                  break;
+        case ALGO_BFS_BIDIR:
+        case ALGO_DIJKSTRA_BIDIR:
+        case ALGO_ASTAR_BIDIR:    bidirStep();                                break;
+        case ALGO_LPA_STAR:       lpaStarStep();                              break;
+        case ALGO_HPA:            hpaStep();                                  break;
+        case ALGO_BFS_PARALLEL:   bfsParallelStep();                          break;
+        case ALGO_DELTA_STEPPING: deltaSteppingStep();                        break;
+        default:                  break;
+    }
+}
+
+b8
+searchShouldStop(void)
+{
+    switch (g_active_algo)
+    {
+        case ALGO_BFS:            return bfsShouldStop();
+        case ALGO_DFS:            return dfsShouldStop();
+        case ALGO_DIJKSTRA:       return dijkstraShouldStop();
+        case ALGO_ASTAR:
+        case ALGO_ASTAR_ALT:      return aStarShouldStop();
+        case ALGO_JPS:
+        case ALGO_JPS_PLUS:       return jpsShouldStop();
+        case ALGO_BFS_BIDIR:
+        case ALGO_DIJKSTRA_BIDIR:
+        case ALGO_ASTAR_BIDIR:    return bidirShouldStop();
+        case ALGO_LPA_STAR:       return lpaStarShouldStop();
+        case ALGO_HPA:            return hpaShouldStop();
+        case ALGO_BFS_PARALLEL:   return bfsParallelShouldStop();
+        case ALGO_DELTA_STEPPING: return deltaSteppingShouldStop();
+        default:                  return 1;
+    }
+}
+
+u64
+searchStepFor(u64 budget_ns)
+{
+    u64 begin = timerNowNs();
+    u64 steps = 0;
+
+    while (!searchShouldStop())
+    {
+        searchStep();
+        steps += 1;
+
+        if ((budget_ns == 0 || steps % SEARCH_CLOCK_INTERVAL == 0) && timerNowNs() - begin >= budget_ns) break;
+    }
+
+    g_search_step_ns += timerNowNs() - begin;
+
+    return steps;
+}
+
+u64
+searchGetElapsedNs(void)
+{
+    return g_search_init_ns + g_search_step_ns;
+}
+
+b8
+searchNotifyCellChanged(u32 cell)
+{
+    // Marks the clusters to rebuild before the next HPA* query
+    hpaCellChanged(cell);
+
+    if (g_active_algo != ALGO_LPA_STAR) return 0;
+
+    u64 begin = timerNowNs();
+
+    g_search_stats = (SearchStats){0};
+    lpaStarCellChanged(cell);
+
+    g_search_init_ns = timerNowNs() - begin;
+    g_search_step_ns = 0;
+
+    return 1;
+}
+
+b8
+searchHasFoundPath(void)
+{
+    // Every algorithm marks the goal as visited only when it reaches it
+    Grid* grid = gridGet();
+
+    return grid->goal != GRID_NO_CELL && gridIsVisited(grid, grid->goal) == 1;
+}
+
+SearchResult
+searchRun(SearchAlgo algo)
+{
+    Grid* grid = gridGet();
+    if (grid->start == GRID_NO_CELL || grid->goal == GRID_NO_CELL) return (SearchResult){0};
+
+    gridReset();
+
+    searchInit(algo);
+    searchStepFor(SEARCH_BUDGET_UNLIMITED);
+
+    return searchGetResult();
+}
+
+SearchResult
+searchGetResult(void)
+{
+    Grid* grid = gridGet();
+
+    SearchResult result = {
+        .found      = searchShouldStop() == 1 && searchHasFoundPath() == 1,
+        .elapsed_ns = g_search_init_ns + g_search_step_ns,
+        .init_ns    = g_search_init_ns,
+        .search_ns  = g_search_step_ns,
+        .stats      = g_search_stats
+    };
+
+    if (result.found == 0) return result;
+
+    u64 begin = timerNowNs();
+
+    for (u32 cell = grid->goal; cell != GRID_NO_CELL; cell = grid->parent[cell])
+    {
+        result.path_length += 1;
+        if (cell != grid->start) result.path_cost += gridStepCost(grid, grid->parent[cell], cell);
+    }
+
+    result.path_ns = timerNowNs() - begin;
+
+    return result;
+}
+
+b8
+searchGetPath(SearchPath* path)
+{
+    Grid* grid = gridGet();
+
+    if (searchShouldStop() == 0 || searchHasFoundPath() == 0)
+    {
+        searchPathClear(path);
+        return 0;
+    }
+
+    searchPathFromParents(path, grid->parent, grid->goal, gridGetCellCount());
+
+    return 1;
+}
+
+u64
+searchResultToJson(SearchAlgo algo, const SearchResult* result, char* buffer, u64 size)
+{
+    int length = snprintf(buffer, size,
+                          "{\"algorithm\":\"%s\",\"found\":%s,\"path_length\":%u,\"path_cost\":%lu,"
+                          "\"expanded\":%lu,\"pushes\":%lu,\"stale_pops\":%lu,\"peak_frontier\":%lu,"
+                          "\"init_ns\":%lu,\"search_ns\":%lu,\"path_ns\":%lu,\"elapsed_ns\":%lu}",
+                          searchAlgoName(algo), result->found == 1 ? "true" : "false",
+                          result->path_length, result->path_cost,
+                          result->stats.expanded, result->stats.pushes, result->stats.stale_pops,
+                          result->stats.peak_frontier,
+                          result->init_ns, result->search_ns, result->path_ns, result->elapsed_ns);
+
+    return length > 0 ? (u64)length : 0;
+}
+
+void
+searchSetThreads(u32 threads)
+{
+    g_search_threads = threads;
+}
+
+u32
+searchGetThreads(void)
+{
+    return g_search_threads;
+}
+
+void
+searchSetDelta(u32 delta)
+{
+    g_search_delta = delta;
+}
+
+u32
+searchGetDelta(void)
+{
+    return g_search_delta;
+}
+
+PriorityQueueKind
+searchResolveQueue(PriorityQueueKind queue, u64 max_step_cost)
+{
+    if (queue == SEARCH_QUEUE_AUTO) return max_step_cost <= SEARCH_MAX_BUCKET_WEIGHT ? PQ_BUCKET : PQ_RADIX;
+
+    // Past this the ring no longer fits in memory, and pqCreate() takes the step as a u32
+    if (queue == PQ_BUCKET && max_step_cost > SEARCH_MAX_BUCKET_RING)
+    {
+        LOG_INFO("Steps of up to %lu are too large for buckets, using a radix heap", max_step_cost);
+        return PQ_RADIX;
+    }
+
+    return queue;
+}
+
+SearchAlgo
+searchResolveAlgo(SearchAlgo algo)
+{
+    const Grid* grid = gridGet();
+
+    // Only these searches move 8-connected, the others are replaced by the
+    // closest one that does
+    if (grid->connectivity == GRID_CONNECT_8)
+    {
+        switch (algo)
+        {
+            case ALGO_BFS_BIDIR:
+            case ALGO_BFS_PARALLEL:   return ALGO_BFS;
+            case ALGO_DIJKSTRA_BIDIR:
+            case ALGO_DELTA_STEPPING: return ALGO_DIJKSTRA;
+            case ALGO_JPS:
+            case ALGO_JPS_PLUS:
+            case ALGO_ASTAR_BIDIR:
+            case ALGO_LPA_STAR:
+            case ALGO_HPA:            return ALGO_ASTAR;
+            default:                  return algo;
+        }
+    }
+
+    // Jump Point Search assumes every step costs 1
+    if ((algo == ALGO_JPS || algo == ALGO_JPS_PLUS) && grid->max_weight > 1) return ALGO_ASTAR;
+
+    return algo;
+}
+
+void
+searchSetQueue(PriorityQueueKind queue)
+{
+    g_search_queue = queue;
+}
+
+PriorityQueueKind
+searchGetQueue(void)
+{
+    return g_search_queue;
+}
+
+SearchStats*
+searchGetStats(void)
+{
+    return &g_search_stats;
+}
+
+const char*
+searchAlgoName(SearchAlgo algo)
+{
+    if (algo >= ALGO_COUNT) return g_algo_names[ALGO_NONE];
+
+    return g_algo_names[algo];
+}
+
+SearchAlgo
+searchAlgoFromName(const char* name)
+{
+    for (u32 algo = ALGO_NONE + 1; algo < ALGO_COUNT; ++algo)
+    {
+        if (strcmp(name, g_algo_names[algo]) == 0) return (SearchAlgo)algo;
+    }
+
+    return ALGO_NONE;
+}
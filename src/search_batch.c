@@ -0,0 +1,171 @@
+#include "search_batch.h"
+
+#include "logger.h"
+
+#include "grid.h"
+#include "search_context.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef struct BatchJob BatchJob;
+
+// The queries [begin, end) not taken yet. The owner takes from the front,
+// thieves split off the back.
+typedef struct BatchWorker
+{
+    pthread_t           thread;
+    pthread_mutex_t     lock;
+    u64                 begin;
+    u64                 end;
+    u32                 id;
+    BatchJob*           job;
+} BatchWorker;
+
+struct BatchJob
+{
+    const Grid*         grid;
+    SearchAlgo          algo;
+    PriorityQueueKind   queue;
+    const SearchQuery*  queries;
+    SearchResult*       results;
+    BatchWorker*        workers;
+    u32                 worker_count;
+};
+
+static b8
+take_own(BatchWorker* worker, u64* index)
+{
+    b8 taken = 0;
+
+    pthread_mutex_lock(&worker->lock);
+    if (worker->begin < worker->end)
+    {
+        *index = worker->begin++;
+        taken  = 1;
+    }
+    pthread_mutex_unlock(&worker->lock);
+
+    return taken;
+}
+
+// Moves the back half of the first other worker with queries left into
+// worker's own slice. Slices only ever shrink, so once a full pass finds
+// nothing the batch is done for this worker.
+static b8
+steal(BatchWorker* worker)
+{
+    BatchJob* job = worker->job;
+
+    for (u32 offset = 1; offset < job->worker_count; ++offset)
+    {
+        BatchWorker* victim = &job->workers[(worker->id + offset) % job->worker_count];
+
+        u64 begin = 0, end = 0;
+
+        pthread_mutex_lock(&victim->lock);
+        if (victim->begin < victim->end)
+        {
+            u64 left     = victim->end - victim->begin;
+            end          = victim->end;
+            begin        = end - (left + 1) / 2;
+            victim->end  = begin;
+        }
+        pthread_mutex_unlock(&victim->lock);
+
+        if (begin == end) continue;
+
+        pthread_mutex_lock(&worker->lock);
+        worker->begin = begin;
+        worker->end   = end;
+        pthread_mutex_unlock(&worker->lock);
+
+        return 1;
+    }
+
+    return 0;
+}
+
+static void*
+worker_main(void* argument)
+{
+    BatchWorker* worker = argument;
+    BatchJob*    job    = worker->job;
+
+    SearchContext context = searchContextCreate(job->grid, job->queue);
+
+    for (;;)
+    {
+        u64 index;
+        if (take_own(worker, &index) == 1)
+        {
+            const SearchQuery* query = &job->queries[index];
+            job->results[index] = searchContextRun(&context, job->algo, query->start, query->goal);
+            continue;
+        }
+
+        if (steal(worker) == 0) break;
+    }
+
+    searchContextDestroy(&context);
+
+    return NULL;
+}
+
+u32
+searchBatchDefaultThreads(void)
+{
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return cores > 0 ? (u32)cores : 1;
+}
+
+void
+searchBatchRun(SearchAlgo algo, PriorityQueueKind queue,
+               const SearchQuery* queries, u64 count, SearchResult* results, u32 threads)
+{
+    if (count == 0) return;
+
+    if (searchContextSupports(algo) == 0)
+    {
+        LOG_INFO("%s can't run in a batch", searchAlgoName(algo));
+        for (u64 i = 0; i < count; ++i) results[i] = (SearchResult){0};
+        return;
+    }
+
+    // Built here, once, rather than by the workers racing over the same grid
+    gridBuildMoves();
+
+    if (threads == 0)     threads = searchBatchDefaultThreads();
+    if (threads > count)  threads = (u32)count;
+
+    BatchJob job = {
+        .grid           = gridGet(),
+        .algo           = algo,
+        .queue          = queue,
+        .queries        = queries,
+        .results        = results,
+        .workers        = calloc(threads, sizeof(BatchWorker)),
+        .worker_count   = threads
+    };
+
+    for (u32 i = 0; i < threads; ++i)
+    {
+        BatchWorker* worker = &job.workers[i];
+
+        worker->id    = i;
+        worker->job   = &job;
+        worker->begin = count * i / threads;
+        worker->end   = count * (i + 1) / threads;
+        pthread_mutex_init(&worker->lock, NULL);
+    }
+
+    // The calling thread works as worker 0
+    for (u32 i = 1; i < threads; ++i) pthread_create(&job.workers[i].thread, NULL, worker_main, &job.workers[i]);
+    worker_main(&job.workers[0]);
+    for (u32 i = 1; i < threads; ++i) pthread_join(job.workers[i].thread, NULL);
+
+    for (u32 i = 0; i < threads; ++i) pthread_mutex_destroy(&job.workers[i].lock);
+    free(job.workers);
+}
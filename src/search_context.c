@@ -0,0 +1,252 @@
+#include "search_context.h"
+
+#include "grid_neighbors.h"
+#include "logger.h"
+#include "timer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+SearchContext
+searchContextCreate(const Grid* grid, PriorityQueueKind queue)
+{
+    u64 cell_count = (u64)grid->rows * grid->cols;
+
+    SearchContext context = {
+        .grid           = grid,
+        .cell_count     = cell_count,
+        .distance       = malloc(cell_count * sizeof(u32)),
+        .parent         = malloc(cell_count * sizeof(u32)),
+        .visited        = calloc((cell_count + 63) / 64, sizeof(u64)),
+        .touched        = malloc(cell_count * sizeof(u32)),
+        .touched_count  = 0
+    };
+
+    memset(context.distance, 0xFF, cell_count * sizeof(u32));
+    memset(context.parent,   0xFF, cell_count * sizeof(u32));
+
+    // With a consistent heuristic, keys grow by at most the step cost plus the
+    // bound of one unweighted step
+    u32 max_step  = (u32)gridMaxStepCost(grid);
+    u32 unit_step = grid->connectivity == GRID_CONNECT_8 ? GRID_COST_DIAGONAL : 1;
+    context.queue = pqCreate(searchResolveQueue(queue, max_step), cell_count, max_step + unit_step);
+
+    return context;
+}
+
+void
+searchContextDestroy(SearchContext* context)
+{
+    free(context->distance);
+    free(context->parent);
+    free(context->visited);
+    free(context->touched);
+    pqDestroy(&context->queue);
+
+    *context = (SearchContext){0};
+}
+
+b8
+searchContextSupports(SearchAlgo algo)
+{
+    return algo == ALGO_BFS || algo == ALGO_DIJKSTRA || algo == ALGO_ASTAR;
+}
+
+// Puts back the cells changed by the previous query, cheaper than clearing
+// the whole grid when queries only explore part of it
+static void
+reset(SearchContext* context)
+{
+    for (u64 i = 0; i < context->touched_count; ++i)
+    {
+        u32 cell = context->touched[i];
+
+        context->distance[cell] = GRID_INFINITY;
+        context->parent[cell]   = GRID_NO_CELL;
+        gridBitClear(context->visited, cell);
+    }
+
+    context->touched_count = 0;
+    context->stats         = (SearchStats){0};
+    pqClear(&context->queue);
+}
+
+// The searches take the movement model as a constant, see grid_neighbors.h
+GRID_KERNEL b8
+run_bfs(SearchContext* context, u32 start, u32 goal, u32 connectivity)
+{
+    const Grid*  grid  = context->grid;
+    SearchStats* stats = &context->stats;
+
+    context->distance[start]                    = 0;
+    context->touched[context->touched_count++]  = start;
+    gridBitSet(context->visited, start);
+    searchStatsPush(stats);
+
+    for (u64 head = 0; head < context->touched_count; ++head)
+    {
+        u32 cell = context->touched[head];
+        searchStatsPop(stats);
+        stats->expanded += 1;
+
+        if (cell == goal) return 1;
+
+        u32 neighbors[8];
+        u32 steps[8];
+        u32 count = gridOpenNeighbors(grid, cell, connectivity, neighbors, steps);
+
+        for (u32 i = 0; i < count; ++i)
+        {
+            u32 neighbor = neighbors[i];
+            if (gridBitTest(context->visited, neighbor) == 1) continue;
+
+            gridBitSet(context->visited, neighbor);
+            context->distance[neighbor]                 = context->distance[cell] + 1;
+            context->parent[neighbor]                   = cell;
+            context->touched[context->touched_count++]  = neighbor;
+            searchStatsPush(stats);
+        }
+    }
+
+    return 0;
+}
+
+// Dijkstra, or A* with gridDistanceBound() as the heuristic
+GRID_KERNEL b8
+run_best_first(SearchContext* context, u32 start, u32 goal, b8 use_heuristic, u32 connectivity)
+{
+    const Grid*    grid  = context->grid;
+    SearchStats*   stats = &context->stats;
+    PriorityQueue* queue = &context->queue;
+
+    context->distance[start]                    = 0;
+    context->touched[context->touched_count++]  = start;
+    pqPush(queue, start, use_heuristic == 1 ? gridDistanceBound(grid, connectivity, start, goal) : 0);
+    searchStatsQueuePush(stats, queue->size);
+
+    while (pqIsEmpty(queue) == 0)
+    {
+        PQEntry entry;
+        pqPop(queue, &entry);
+        searchStatsPop(stats);
+
+        u32 cell = entry.cell;
+        if (gridBitTest(context->visited, cell) == 1)
+        {
+            stats->stale_pops += 1;
+            continue;
+        }
+        gridBitSet(context->visited, cell);
+        stats->expanded += 1;
+
+        if (cell == goal) return 1;
+
+        u32 neighbors[8];
+        u32 steps[8];
+        u32 count = gridOpenNeighbors(grid, cell, connectivity, neighbors, steps);
+
+        for (u32 i = 0; i < count; ++i)
+        {
+            u32 neighbor = neighbors[i];
+            if (gridBitTest(context->visited, neighbor) == 1) continue;
+
+            u64 temp = (u64)context->distance[cell] + gridMoveCost(grid, connectivity, neighbors, steps, i);
+            if (temp >= context->distance[neighbor]) continue;
+
+            if (context->distance[neighbor] == GRID_INFINITY) context->touched[context->touched_count++] = neighbor;
+
+            context->distance[neighbor] = temp;
+            context->parent[neighbor]   = cell;
+
+            u32 bound = use_heuristic == 1 ? gridDistanceBound(grid, connectivity, neighbor, goal) : 0;
+            pqPush(queue, neighbor, temp + bound);
+            searchStatsQueuePush(stats, queue->size);
+        }
+    }
+
+    return 0;
+}
+
+static b8
+run_bfs_4(SearchContext* context, u32 start, u32 goal)
+{
+    return run_bfs(context, start, goal, GRID_CONNECT_4);
+}
+
+static b8
+run_bfs_8(SearchContext* context, u32 start, u32 goal)
+{
+    return run_bfs(context, start, goal, GRID_CONNECT_8);
+}
+
+static b8
+run_best_first_4(SearchContext* context, u32 start, u32 goal, b8 use_heuristic)
+{
+    return run_best_first(context, start, goal, use_heuristic, GRID_CONNECT_4);
+}
+
+static b8
+run_best_first_8(SearchContext* context, u32 start, u32 goal, b8 use_heuristic)
+{
+    return run_best_first(context, start, goal, use_heuristic, GRID_CONNECT_8);
+}
+
+SearchResult
+searchContextRun(SearchContext* context, SearchAlgo algo, u32 start, u32 goal)
+{
+    SearchResult result = {0};
+    if (searchContextSupports(algo) == 0 || start >= context->cell_count || goal >= context->cell_count) return result;
+
+    if (context->grid->moves == NULL)
+    {
+        LOG_ERROR("Grid moves aren't built, call gridBuildMoves() first");
+        return result;
+    }
+
+    u64 begin = timerNowNs();
+
+    reset(context);
+
+    u64 search_begin = timerNowNs();
+
+    b8 diagonal = context->grid->connectivity == GRID_CONNECT_8;
+
+    switch (algo)
+    {
+        case ALGO_BFS:
+            result.found = diagonal == 1 ? run_bfs_8(context, start, goal) : run_bfs_4(context, start, goal);
+            break;
+        case ALGO_DIJKSTRA:
+        case ALGO_ASTAR:
+            result.found = diagonal == 1 ? run_best_first_8(context, start, goal, algo == ALGO_ASTAR)
+                                    : run_best_first_4(context, start, goal, algo == ALGO_ASTAR);
+            break;
+        default:
+            break;
+    }
+
+    u64 search_end = timerNowNs();
+
+    if (result.found == 1)
+    {
+        for (u32 cell = goal; cell != GRID_NO_CELL; cell = context->parent[cell])
+        {
+            result.path_length += 1;
+            if (cell != start) result.path_cost += gridStepCost(context->grid, context->parent[cell], cell);
+        }
+    }
+
+    result.init_ns    = search_begin - begin;
+    result.search_ns  = search_end - search_begin;
+    result.path_ns    = timerNowNs() - search_end;
+    result.elapsed_ns = search_end - begin;
+    result.stats      = context->stats;
+
+    return result;
+}
+
+void
+searchContextGetPath(const SearchContext* context, u32 goal, SearchPath* path)
+{
+    searchPathFromParents(path, context->parent, goal, context->cell_count);
+}
@@ -0,0 +1,92 @@
+#include "search_kernel.h"
+
+#include "logger.h"
+
+#include <stdlib.h>
+
+static void
+kernel_release(SearchKernel* kernel)
+{
+    if (kernel->frontier == SEARCH_FRONTIER_PRIORITY)
+    {
+        pqDestroy(&kernel->queue);
+    }
+    else
+    {
+        free(kernel->cells);
+        kernel->cells = NULL;
+    }
+}
+
+void
+searchKernelInit(SearchKernel* kernel, u32 frontier, u32 heuristic, u64 capacity, PriorityQueueKind queue)
+{
+    Grid* grid = gridGet();
+    u32   root = grid->start;
+
+    // A search cancelled or restarted before it finished still holds its frontier
+    if (kernel->is_running == 1) kernel_release(kernel);
+
+    *kernel = (SearchKernel){
+        .grid           = grid,
+        .stats          = searchGetStats(),
+        .frontier       = frontier,
+        .is_running     = 1,
+        .has_finished   = 0
+    };
+
+    gridTouch(grid, root);
+
+    if (frontier != SEARCH_FRONTIER_PRIORITY)
+    {
+        kernel->cells = malloc(capacity * sizeof(u32));
+        kernel->cells[kernel->tail++] = root;
+        searchStatsPush(kernel->stats);
+        gridMarkVisited(grid, root);
+        TRACE_EVENT(TRACE_PUSH, root, 0);
+
+        return;
+    }
+
+    // With a consistent heuristic, keys grow by at most the step cost plus the
+    // change of the bound over one step: one unweighted step for the distance,
+    // up to the cost of the step back for the landmarks
+    u32 max_key_step = (u32)gridMaxStepCost(grid);
+    if (heuristic == SEARCH_HEURISTIC_DISTANCE)  max_key_step += grid->connectivity == GRID_CONNECT_8 ? GRID_COST_DIAGONAL : 1;
+    if (heuristic == SEARCH_HEURISTIC_LANDMARKS) max_key_step *= 2;
+
+    kernel->queue = pqCreate(queue, capacity, max_key_step);
+    if (heuristic == SEARCH_HEURISTIC_LANDMARKS) kernel->landmarks = landmarksPrepare();
+
+    grid->distance[root] = 0;
+    if (heuristic != SEARCH_HEURISTIC_NONE) grid->heuristic[root] = searchKernelBound(kernel, heuristic, grid->connectivity, root);
+
+    pqPush(&kernel->queue, root, grid->heuristic[root]);
+    searchStatsQueuePush(kernel->stats, kernel->queue.size);
+    TRACE_EVENT(TRACE_PUSH, root, grid->heuristic[root]);
+}
+
+void
+searchKernelFinish(SearchKernel* kernel, b8 found)
+{
+    if (found == 1)
+    {
+        LOG_INFO("Found path!");
+        if (kernel->frontier == SEARCH_FRONTIER_PRIORITY) LOG_INFO("Distance %u", kernel->grid->distance[kernel->grid->goal]);
+    }
+    else
+    {
+        LOG_INFO("Could not find path!");
+    }
+
+    kernel->is_running   = 0;
+    kernel->has_finished = 1;
+
+    kernel_release(kernel);
+}
+
+b8
+searchKernelShouldStop(const SearchKernel* kernel)
+{
+    return (kernel->is_running == 0) && (kernel->has_finished == 1);
+}
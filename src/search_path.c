@@ -0,0 +1,137 @@
+#include "search_path.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#define SEARCH_PATH_MIN_CAPACITY 64
+
+void
+searchPathPush(SearchPath* path, u32 cell)
+{
+    if (path->count == path->capacity)
+    {
+        path->capacity = path->capacity == 0 ? SEARCH_PATH_MIN_CAPACITY : 2 * path->capacity;
+        path->cells    = realloc(path->cells, path->capacity * sizeof(u32));
+    }
+
+    path->cells[path->count++] = cell;
+}
+
+void
+searchPathClear(SearchPath* path)
+{
+    path->count = 0;
+}
+
+void
+searchPathFree(SearchPath* path)
+{
+    free(path->cells);
+    *path = (SearchPath){0};
+}
+
+void
+searchPathFromParents(SearchPath* path, const u32* parent, u32 goal, u64 cell_count)
+{
+    searchPathClear(path);
+
+    for (u32 cell = goal; cell != GRID_NO_CELL && path->count < cell_count; cell = parent[cell])
+    {
+        searchPathPush(path, cell);
+    }
+
+    if (path->count == 0) return;
+
+    // Collected from the goal back, one pass over the array beats a second walk of the parents
+    for (u32 low = 0, high = path->count - 1; low < high; ++low, --high)
+    {
+        u32 cell          = path->cells[low];
+        path->cells[low]  = path->cells[high];
+        path->cells[high] = cell;
+    }
+}
+
+b8
+searchPathHasLineOfSight(const Grid* grid, u32 a, u32 b)
+{
+    i64 cols      = grid->cols;
+    i64 row       = a / cols;
+    i64 col       = a % cols;
+    i64 row_count = (i64)(b / cols) - row;
+    i64 col_count = (i64)(b % cols) - col;
+    i64 row_step  = row_count < 0 ? -1 : 1;
+    i64 col_step  = col_count < 0 ? -1 : 1;
+
+    row_count *= row_step;
+    col_count *= col_step;
+
+    // Visits the cells the segment enters in order. Going from center to
+    // center, it crosses its i-th column border at t = (2i + 1) / (2 col_count)
+    // and its j-th row border at t = (2j + 1) / (2 row_count), so comparing
+    // the two numerators tells which comes first without any division.
+    for (i64 i = 0, j = 0; i < col_count || j < row_count;)
+    {
+        i64 side = (2 * i + 1) * row_count - (2 * j + 1) * col_count;
+
+        if (side == 0)
+        {
+            if (gridIsWall(grid, (row + row_step) * cols + col) == 1 ||
+                gridIsWall(grid, row * cols + col + col_step) == 1) return 0;
+
+            row += row_step;
+            col += col_step;
+            i   += 1;
+            j   += 1;
+        }
+        else if (side < 0)
+        {
+            col += col_step;
+            i   += 1;
+        }
+        else
+        {
+            row += row_step;
+            j   += 1;
+        }
+
+        if (gridIsWall(grid, row * cols + col) == 1) return 0;
+    }
+
+    return 1;
+}
+
+void
+searchPathSmooth(const Grid* grid, const SearchPath* path, SearchPath* waypoints)
+{
+    searchPathClear(waypoints);
+    if (path->count == 0) return;
+
+    u32 anchor = path->cells[0];
+    searchPathPush(waypoints, anchor);
+
+    // A cell stays when the last waypoint can't see the one after it
+    for (u32 i = 1; i + 1 < path->count; ++i)
+    {
+        if (searchPathHasLineOfSight(grid, anchor, path->cells[i + 1]) == 1) continue;
+
+        anchor = path->cells[i];
+        searchPathPush(waypoints, anchor);
+    }
+
+    if (path->count > 1) searchPathPush(waypoints, path->cells[path->count - 1]);
+}
+
+double
+searchPathLength(const Grid* grid, const SearchPath* path)
+{
+    double length = 0.0;
+
+    for (u32 i = 1; i < path->count; ++i)
+    {
+        double rows = (double)(path->cells[i] / grid->cols) - (double)(path->cells[i - 1] / grid->cols);
+        double cols = (double)(path->cells[i] % grid->cols) - (double)(path->cells[i - 1] % grid->cols);
+        length += sqrt(rows * rows + cols * cols);
+    }
+
+    return length;
+}
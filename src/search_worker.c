@@ -0,0 +1,385 @@
+#include "search_worker.h"
+
+#include "logger.h"
+
+#include "grid.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Steps between two looks at the commands when the search runs freely, so a
+// pause or a cancel waits at most this long
+#define SEARCH_WORKER_SLICE_NS  2000000
+
+// Sleep while the ring is full, until the renderer made room
+#define SEARCH_WORKER_WAIT_NS   250000
+
+typedef enum {
+    WORKER_IDLE     = 0,    // no search, or its last event was published
+    WORKER_SEARCH   = 1,    // stepping
+    WORKER_PATH     = 2     // stopped, publishing the path and the outcome
+} WorkerPhase;
+
+typedef struct SearchWorker
+{
+    pthread_t           thread;
+    pthread_mutex_t     lock;
+    pthread_cond_t      wake;           // a command or a grant arrived
+    pthread_cond_t      parked;         // the worker finished a slice
+
+    // Guarded by lock
+    SearchAlgo          pending;        // search to start, ALGO_NONE for none
+    u64                 budget_ns;
+    b8                  has_grant;
+    b8                  is_cancelled;
+    b8                  is_paused;
+    b8                  is_parked;
+    b8                  is_running;
+    b8                  should_quit;
+    WorkerPhase         phase;
+    b8                  is_synced;      // every cell change was published
+    SearchResult        result;
+
+    // Worker thread only: the state of each cell as the renderer knows it
+    u64*                sent_visited;
+    u64*                sent_frontier;
+    u64                 word_count;
+    SearchPath          path;           // of the search that stopped
+    u32                 path_sent;      // cells of path published so far
+    b8                  needs_reset;
+
+    SearchEventRing     ring;
+} SearchWorker;
+
+static SearchWorker g_worker = {0};
+
+// Publishes the cells whose state changed since the last call. Returns 0
+// when the ring filled up first, the rest goes out on the next call.
+static b8
+publish_cells(SearchWorker* worker)
+{
+    const Grid* grid = gridGet();
+
+    for (u64 word = 0; word < worker->word_count; ++word)
+    {
+        u64 visited  = grid->visited[word];
+        u64 frontier = grid->reached[word] & ~visited;
+        u64 changed  = (visited ^ worker->sent_visited[word]) | (frontier ^ worker->sent_frontier[word]);
+
+        for (; changed != 0; changed &= changed - 1)
+        {
+            u64 bit  = changed & -changed;
+            u32 cell = word * 64 + __builtin_ctzll(changed);
+            u32 kind = (visited  & bit) != 0 ? SEARCH_EVENT_VISIT :
+                       (frontier & bit) != 0 ? SEARCH_EVENT_FRONTIER : SEARCH_EVENT_CLEAR;
+
+            if (searchEventRingPush(&worker->ring, (SearchEvent){ kind, cell }) == 0) return 0;
+
+            worker->sent_visited[word]  = (worker->sent_visited[word]  & ~bit) | (visited  & bit);
+            worker->sent_frontier[word] = (worker->sent_frontier[word] & ~bit) | (frontier & bit);
+        }
+    }
+
+    return 1;
+}
+
+// Publishes the path from the start to the goal, then the outcome. Returns
+// 0 when the ring filled up first.
+static b8
+publish_path(SearchWorker* worker)
+{
+    for (; worker->path_sent < worker->path.count; ++worker->path_sent)
+    {
+        SearchEvent event = { SEARCH_EVENT_PATH, worker->path.cells[worker->path_sent] };
+        if (searchEventRingPush(&worker->ring, event) == 0) return 0;
+    }
+
+    u32 goal = worker->path.count > 0 ? gridGetGoal() : GRID_NO_CELL;
+
+    return searchEventRingPush(&worker->ring, (SearchEvent){ SEARCH_EVENT_DONE, goal });
+}
+
+// Runs on the worker thread. The map only changes while the worker is
+// parked, so reading it here needs no lock.
+static void
+begin_search(SearchWorker* worker, SearchAlgo algo)
+{
+    u64 word_count = (gridGetCellCount() + 63) / 64;
+
+    if (word_count != worker->word_count)
+    {
+        free(worker->sent_visited);
+        free(worker->sent_frontier);
+
+        worker->sent_visited  = calloc(word_count, sizeof(u64));
+        worker->sent_frontier = calloc(word_count, sizeof(u64));
+        worker->word_count    = word_count;
+    }
+    else
+    {
+        memset(worker->sent_visited,  0, word_count * sizeof(u64));
+        memset(worker->sent_frontier, 0, word_count * sizeof(u64));
+    }
+
+    gridReset();
+    searchInit(algo);
+
+    worker->needs_reset = 1;
+}
+
+static b8
+has_work(const SearchWorker* worker)
+{
+    if (worker->pending != ALGO_NONE)   return 1;
+    if (worker->phase == WORKER_IDLE)   return 0;
+    if (worker->is_cancelled == 1)      return 1;
+    if (worker->phase == WORKER_PATH)   return 1;
+
+    return worker->is_synced == 0 || worker->budget_ns == SEARCH_BUDGET_UNLIMITED || worker->has_grant == 1;
+}
+
+static void
+wait_for_room(void)
+{
+    struct timespec wait = { 0, SEARCH_WORKER_WAIT_NS };
+    nanosleep(&wait, NULL);
+}
+
+static void*
+worker_main(void* arg)
+{
+    SearchWorker* worker = arg;
+
+    pthread_mutex_lock(&worker->lock);
+    for (;;)
+    {
+        worker->is_parked = 1;
+        pthread_cond_broadcast(&worker->parked);
+
+        while (worker->should_quit == 0 && (worker->is_paused == 1 || has_work(worker) == 0))
+        {
+            pthread_cond_wait(&worker->wake, &worker->lock);
+        }
+        if (worker->should_quit == 1) break;
+
+        worker->is_parked = 0;
+
+        if (worker->pending != ALGO_NONE)
+        {
+            SearchAlgo algo = worker->pending;
+            worker->pending      = ALGO_NONE;
+            worker->is_cancelled = 0;
+
+            pthread_mutex_unlock(&worker->lock);
+            begin_search(worker, algo);
+            SearchResult result = searchGetResult();
+            pthread_mutex_lock(&worker->lock);
+
+            worker->phase     = WORKER_SEARCH;
+            worker->is_synced = 0;
+            worker->result    = result;
+            continue;
+        }
+
+        // A search only steps once the renderer heard of its last steps
+        b8  is_cancelled = worker->is_cancelled;
+        b8  should_step  = is_cancelled == 0 && worker->phase == WORKER_SEARCH && worker->is_synced == 1 &&
+                           (worker->budget_ns == SEARCH_BUDGET_UNLIMITED || worker->has_grant == 1);
+        u64 budget_ns    = worker->budget_ns == SEARCH_BUDGET_UNLIMITED ? SEARCH_WORKER_SLICE_NS : worker->budget_ns;
+        if (should_step == 1) worker->has_grant = 0;
+
+        pthread_mutex_unlock(&worker->lock);
+
+        if (should_step == 1) searchStepFor(budget_ns);
+
+        b8 is_full   = worker->needs_reset == 1 &&
+                       searchEventRingPush(&worker->ring, (SearchEvent){ SEARCH_EVENT_RESET, GRID_NO_CELL }) == 0;
+        if (is_full == 0) worker->needs_reset = 0;
+
+        b8 is_synced = is_full == 0 && publish_cells(worker) == 1;
+        b8 is_done   = 0;
+
+        if (is_synced == 1 && is_cancelled == 1)
+        {
+            is_done = searchEventRingPush(&worker->ring, (SearchEvent){ SEARCH_EVENT_CANCELLED, GRID_NO_CELL });
+        }
+        else if (is_synced == 1 && (worker->phase == WORKER_PATH || searchShouldStop() == 1))
+        {
+            // Only this thread writes the phase, reading it without the lock is safe
+            if (worker->phase == WORKER_SEARCH)
+            {
+                searchGetPath(&worker->path);
+                worker->path_sent = 0;
+            }
+            is_done = publish_path(worker);
+
+            pthread_mutex_lock(&worker->lock);
+            worker->phase = WORKER_PATH;
+            pthread_mutex_unlock(&worker->lock);
+        }
+
+        SearchResult result = searchGetResult();
+
+        pthread_mutex_lock(&worker->lock);
+        worker->is_synced = is_synced;
+        worker->result    = result;
+
+        if (is_done == 1)
+        {
+            // A new search may have been started meanwhile, it keeps running
+            worker->phase        = WORKER_IDLE;
+            worker->is_cancelled = 0;
+            worker->is_running   = worker->pending != ALGO_NONE;
+        }
+
+        if (is_synced == 0 || (is_done == 0 && (is_cancelled == 1 || worker->phase == WORKER_PATH)))
+        {
+            pthread_mutex_unlock(&worker->lock);
+            wait_for_room();
+            pthread_mutex_lock(&worker->lock);
+        }
+    }
+    pthread_mutex_unlock(&worker->lock);
+
+    return NULL;
+}
+
+void
+searchWorkerCreate(void)
+{
+    g_worker = (SearchWorker){
+        .pending    = ALGO_NONE,
+        .budget_ns  = 0,
+        .phase      = WORKER_IDLE,
+        .is_synced  = 1,
+        .ring       = {
+            .events = malloc(SEARCH_EVENT_RING_CAPACITY * sizeof(SearchEvent)),
+            .mask   = SEARCH_EVENT_RING_CAPACITY - 1
+        }
+    };
+
+    pthread_mutex_init(&g_worker.lock, NULL);
+    pthread_cond_init(&g_worker.wake, NULL);
+    pthread_cond_init(&g_worker.parked, NULL);
+    pthread_create(&g_worker.thread, NULL, worker_main, &g_worker);
+
+    LOG_DEBUG("Search worker: %u events, %lu bytes", SEARCH_EVENT_RING_CAPACITY,
+              SEARCH_EVENT_RING_CAPACITY * sizeof(SearchEvent));
+}
+
+void
+searchWorkerDestroy(void)
+{
+    pthread_mutex_lock(&g_worker.lock);
+    g_worker.should_quit = 1;
+    pthread_cond_signal(&g_worker.wake);
+    pthread_mutex_unlock(&g_worker.lock);
+
+    pthread_join(g_worker.thread, NULL);
+
+    pthread_cond_destroy(&g_worker.parked);
+    pthread_cond_destroy(&g_worker.wake);
+    pthread_mutex_destroy(&g_worker.lock);
+
+    free(g_worker.sent_visited);
+    free(g_worker.sent_frontier);
+    searchPathFree(&g_worker.path);
+    free(g_worker.ring.events);
+
+    g_worker = (SearchWorker){0};
+}
+
+void
+searchWorkerStart(SearchAlgo algo)
+{
+    pthread_mutex_lock(&g_worker.lock);
+    g_worker.pending      = algo;
+    g_worker.is_cancelled = 0;
+    g_worker.is_running   = 1;
+    pthread_cond_signal(&g_worker.wake);
+    pthread_mutex_unlock(&g_worker.lock);
+}
+
+void
+searchWorkerCancel(void)
+{
+    pthread_mutex_lock(&g_worker.lock);
+    g_worker.pending = ALGO_NONE;
+
+    if (g_worker.phase != WORKER_IDLE) g_worker.is_cancelled = 1;
+    else                               g_worker.is_running   = 0;
+
+    pthread_cond_signal(&g_worker.wake);
+    pthread_mutex_unlock(&g_worker.lock);
+}
+
+void
+searchWorkerSetBudget(u64 budget_ns)
+{
+    pthread_mutex_lock(&g_worker.lock);
+    g_worker.budget_ns = budget_ns;
+    pthread_cond_signal(&g_worker.wake);
+    pthread_mutex_unlock(&g_worker.lock);
+}
+
+void
+searchWorkerGrant(void)
+{
+    pthread_mutex_lock(&g_worker.lock);
+    g_worker.has_grant = 1;
+    pthread_cond_signal(&g_worker.wake);
+    pthread_mutex_unlock(&g_worker.lock);
+}
+
+void
+searchWorkerPause(void)
+{
+    pthread_mutex_lock(&g_worker.lock);
+    g_worker.is_paused = 1;
+    while (g_worker.is_parked == 0) pthread_cond_wait(&g_worker.parked, &g_worker.lock);
+    pthread_mutex_unlock(&g_worker.lock);
+}
+
+void
+searchWorkerResume(b8 replans)
+{
+    pthread_mutex_lock(&g_worker.lock);
+    g_worker.is_paused = 0;
+    g_worker.is_synced = 0;     // publish the repairs before stepping on
+
+    if (replans == 1 && g_worker.phase == WORKER_IDLE && g_worker.pending == ALGO_NONE)
+    {
+        g_worker.phase      = WORKER_SEARCH;
+        g_worker.is_running = 1;
+    }
+    pthread_cond_signal(&g_worker.wake);
+    pthread_mutex_unlock(&g_worker.lock);
+}
+
+b8
+searchWorkerIsRunning(void)
+{
+    pthread_mutex_lock(&g_worker.lock);
+    b8 is_running = g_worker.is_running;
+    pthread_mutex_unlock(&g_worker.lock);
+
+    return is_running;
+}
+
+SearchResult
+searchWorkerGetResult(void)
+{
+    pthread_mutex_lock(&g_worker.lock);
+    SearchResult result = g_worker.result;
+    pthread_mutex_unlock(&g_worker.lock);
+
+    return result;
+}
+
+b8
+searchWorkerPollEvent(SearchEvent* event)
+{
+    return searchEventRingPop(&g_worker.ring, event);
+}
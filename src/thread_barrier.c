@@ -0,0 +1,38 @@
+#include "thread_barrier.h"
+
+void
+barrierInit(ThreadBarrier* barrier, u32 count)
+{
+    pthread_mutex_init(&barrier->lock, NULL);
+    pthread_cond_init(&barrier->cond, NULL);
+    barrier->count      = count;
+    barrier->waiting    = 0;
+    barrier->generation = 0;
+}
+
+void
+barrierDestroy(ThreadBarrier* barrier)
+{
+    pthread_mutex_destroy(&barrier->lock);
+    pthread_cond_destroy(&barrier->cond);
+}
+
+void
+barrierWait(ThreadBarrier* barrier)
+{
+    pthread_mutex_lock(&barrier->lock);
+
+    u64 generation = barrier->generation;
+    if (++barrier->waiting == barrier->count)
+    {
+        barrier->waiting     = 0;
+        barrier->generation += 1;
+        pthread_cond_broadcast(&barrier->cond);
+    }
+    else
+    {
+        while (generation == barrier->generation) pthread_cond_wait(&barrier->cond, &barrier->lock);
+    }
+
+    pthread_mutex_unlock(&barrier->lock);
+}
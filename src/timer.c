@@ -0,0 +1,12 @@
+#include "timer.h"
+
+#include <time.h>
+
+u64
+timerNowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (u64)ts.tv_sec * 1000000000ull + (u64)ts.tv_nsec;
+}
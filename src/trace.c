@@ -0,0 +1,199 @@
+#include "trace.h"
+
+#include "logger.h"
+
+#include "grid.h"
+#include "landmarks.h"
+#include "search.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// "PFTR" when read as a little-endian u32
+#define TRACE_MAGIC     0x52544650u
+#define TRACE_VERSION   1
+
+// Followed by count events
+typedef struct TraceFileHeader
+{
+    u32     magic;
+    u32     version;
+    u32     algo;
+    u32     rows;
+    u32     cols;
+    u32     connectivity;
+    u32     start;
+    u32     goal;
+    u32     queue;
+    u32     landmark_count;
+    u64     recorded;
+    u64     count;
+} TraceFileHeader;
+
+TraceBuffer g_trace_buffer = {0};
+
+static u64  g_trace_capacity = TRACE_DEFAULT_CAPACITY;
+static u64  g_trace_size     = 0;   // capacity of the allocated buffer
+static u32  g_trace_algo     = 0;
+
+static const char* g_trace_kind_names[TRACE_KIND_COUNT] = {
+    [TRACE_PUSH]  = "push",
+    [TRACE_POP]   = "pop",
+    [TRACE_RELAX] = "relax",
+    [TRACE_GOAL]  = "goal"
+};
+
+void
+traceSetCapacity(u64 capacity)
+{
+    u64 size = 1;
+    while (size < capacity) size <<= 1;
+
+    g_trace_capacity = size;
+}
+
+u64
+traceGetCapacity(void)
+{
+    return g_trace_capacity;
+}
+
+void
+traceBegin(u32 algo)
+{
+    if (g_trace_size != g_trace_capacity)
+    {
+        free(g_trace_buffer.events);
+        g_trace_buffer.events = malloc(g_trace_capacity * sizeof(TraceEvent));
+        g_trace_size          = g_trace_capacity;
+
+        LOG_DEBUG("Trace buffer: %lu events, %lu bytes", g_trace_size, g_trace_size * sizeof(TraceEvent));
+    }
+
+    g_trace_buffer.mask     = g_trace_size - 1;
+    g_trace_buffer.recorded = 0;
+    g_trace_algo            = algo;
+}
+
+void
+traceDestroy(void)
+{
+    free(g_trace_buffer.events);
+    g_trace_buffer = (TraceBuffer){0};
+    g_trace_size   = 0;
+}
+
+u64
+traceGetRecorded(void)
+{
+    return g_trace_buffer.recorded;
+}
+
+b8
+traceSave(const char* path)
+{
+    const Grid* grid     = gridGet();
+    u64         recorded = g_trace_buffer.recorded;
+    u64         count    = recorded < g_trace_size ? recorded : g_trace_size;
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL)
+    {
+        LOG_ERROR("Could not write trace: %s", path);
+        return 0;
+    }
+
+    TraceFileHeader header = {
+        .magic          = TRACE_MAGIC,
+        .version        = TRACE_VERSION,
+        .algo           = g_trace_algo,
+        .rows           = grid->rows,
+        .cols           = grid->cols,
+        .connectivity   = grid->connectivity,
+        .start          = grid->start,
+        .goal           = grid->goal,
+        .queue          = searchGetQueue(),
+        .landmark_count = landmarksGetCount(),
+        .recorded       = recorded,
+        .count          = count
+    };
+
+    b8 written = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    // Oldest first: once the buffer wrapped, the oldest event sits at the write position
+    u64 first = recorded - count;
+    u64 head  = count == 0 ? 0 : first & g_trace_buffer.mask;
+    u64 split = count < g_trace_size - head ? count : g_trace_size - head;
+
+    if (written == 1 && count > 0)
+    {
+        written = fwrite(g_trace_buffer.events + head, sizeof(TraceEvent), split, file) == split &&
+                  fwrite(g_trace_buffer.events, sizeof(TraceEvent), count - split, file) == count - split;
+    }
+
+    if (fclose(file) != 0) written = 0;
+    if (written == 0) LOG_ERROR("Could not write trace: %s", path);
+
+    return written;
+}
+
+b8
+traceLoad(const char* path, Trace* trace)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        LOG_ERROR("Could not read trace: %s", path);
+        return 0;
+    }
+
+    TraceFileHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        header.magic != TRACE_MAGIC || header.version != TRACE_VERSION ||
+        header.count > header.recorded)
+    {
+        LOG_ERROR("Not a trace file: %s", path);
+        fclose(file);
+        return 0;
+    }
+
+    *trace = (Trace){
+        .algo           = header.algo,
+        .rows           = header.rows,
+        .cols           = header.cols,
+        .connectivity   = header.connectivity,
+        .start          = header.start,
+        .goal           = header.goal,
+        .queue          = header.queue,
+        .landmark_count = header.landmark_count,
+        .recorded       = header.recorded,
+        .count          = header.count,
+        .events         = malloc(header.count * sizeof(TraceEvent))
+    };
+
+    b8 loaded = (trace->events != NULL || header.count == 0) &&
+                fread(trace->events, sizeof(TraceEvent), header.count, file) == header.count;
+    fclose(file);
+
+    if (loaded == 0)
+    {
+        LOG_ERROR("Truncated trace file: %s", path);
+        traceFree(trace);
+        return 0;
+    }
+
+    return 1;
+}
+
+void
+traceFree(Trace* trace)
+{
+    free(trace->events);
+    *trace = (Trace){0};
+}
+
+const char*
+traceKindName(u32 kind)
+{
+    return kind < TRACE_KIND_COUNT ? g_trace_kind_names[kind] : "unknown";
+}
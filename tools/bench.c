@@ -0,0 +1,589 @@
+#include "logger.h"
+
+#include "grid.h"
+#include "landmarks.h"
+#include "search.h"
+#include "search_batch.h"
+#include "priority_queue.h"
+#include "timer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define BENCH_MAX_ITEMS 16
+
+typedef enum {
+    WEIGHTS_UNIT    = 0,    // every cell costs 1
+    WEIGHTS_UNIFORM = 1,    // uniform in [1, 9]
+    WEIGHTS_SKEWED  = 2,    // mostly 1, one cell in ten costs 5..9
+    WEIGHTS_COUNT
+} BenchWeights;
+
+static const char* g_weight_names[WEIGHTS_COUNT] = {
+    [WEIGHTS_UNIT]    = "unit",
+    [WEIGHTS_UNIFORM] = "uniform",
+    [WEIGHTS_SKEWED]  = "skewed"
+};
+
+typedef struct BenchConfig
+{
+    u32     sizes[BENCH_MAX_ITEMS];
+    u32     size_count;
+    u32     densities[BENCH_MAX_ITEMS];     // wall percentage
+    u32     density_count;
+    u32     weights[BENCH_MAX_ITEMS];
+    u32     weight_count;
+    u32     algos[BENCH_MAX_ITEMS];
+    u32     algo_count;
+    u32     queues[BENCH_MAX_ITEMS];        // priority queue searches only
+    u32     queue_count;
+    u32     threads[BENCH_MAX_ITEMS];       // batch mode, bfs-par and delta
+    u32     thread_count;
+    u32     batch;                          // queries per map, 0 runs the single-query matrix
+    u32     delta;                          // delta-stepping bucket width, 0 for the largest weight
+    u32     connectivity;                   // GRID_CONNECT_4 or GRID_CONNECT_8
+    u32     landmarks;                      // placed by astar-alt
+    u32     repeat;
+    u64     seed;
+    const char* output;
+} BenchConfig;
+
+static u64
+xorshift64(u64* state)
+{
+    u64 x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+static u32
+weight_sample(BenchWeights weights, u64* rng)
+{
+    switch (weights)
+    {
+        case WEIGHTS_UNIFORM:   return 1 + xorshift64(rng) % 9;
+        case WEIGHTS_SKEWED:    return xorshift64(rng) % 10 == 0 ? 5 + xorshift64(rng) % 5 : 1;
+        default:                return 1;
+    }
+}
+
+// Random walls at the given density, start in the top-left and goal in the bottom-right corner
+static void
+generate_grid(u32 size, u32 density, BenchWeights weights, u64 seed)
+{
+    u64 rng = seed * 0x9E3779B97F4A7C15ull + size * 31 + density * 7 + weights + 1;
+
+    gridCreate(size, size);
+
+    for (u32 row = 0; row < size; ++row)
+    {
+        for (u32 col = 0; col < size; ++col)
+        {
+            if (xorshift64(&rng) % 100 < density)   gridSetWall(row, col, 1);
+            else                                    gridSetWeight(row, col, weight_sample(weights, &rng));
+        }
+    }
+
+    gridSetStart(0, 0);
+    gridSetGoal(size - 1, size - 1);
+}
+
+// Keeps the fastest of repeat runs of algo. They run in a child process that
+// starts from the generated grid and exits afterwards, so its peak resident
+// memory belongs to this configuration and not to every one run before it.
+static b8
+run_isolated(SearchAlgo algo, u32 repeat, SearchResult* best, u64* rss_kb)
+{
+    int channel[2];
+    if (pipe(channel) != 0)
+    {
+        LOG_ERROR("Could not create a pipe for %s", searchAlgoName(algo));
+        return 0;
+    }
+
+    // Buffered output would otherwise be written again by the child
+    fflush(NULL);
+
+    pid_t child = fork();
+    if (child < 0)
+    {
+        LOG_ERROR("Could not fork a process for %s", searchAlgoName(algo));
+        close(channel[0]);
+        close(channel[1]);
+        return 0;
+    }
+
+    if (child == 0)
+    {
+        close(channel[0]);
+
+        SearchResult fastest = {0};
+        for (u32 r = 0; r < repeat; ++r)
+        {
+            SearchResult result = searchRun(algo);
+            if (r == 0 || result.elapsed_ns < fastest.elapsed_ns) fastest = result;
+        }
+
+        b8 sent = write(channel[1], &fastest, sizeof(fastest)) == (ssize_t)sizeof(fastest);
+        _exit(sent == 1 ? 0 : 1);
+    }
+
+    close(channel[1]);
+
+    u64 received = 0;
+    while (received < sizeof(*best))
+    {
+        ssize_t count = read(channel[0], (u8*)best + received, sizeof(*best) - received);
+        if (count <= 0) break;
+        received += (u64)count;
+    }
+    close(channel[0]);
+
+    int           status;
+    struct rusage usage;
+    if (wait4(child, &status, 0, &usage) != child || WIFEXITED(status) == 0 || WEXITSTATUS(status) != 0 ||
+        received != sizeof(*best))
+    {
+        LOG_ERROR("The process running %s failed", searchAlgoName(algo));
+        return 0;
+    }
+
+    *rss_kb = (u64)usage.ru_maxrss;
+    return 1;
+}
+
+static u32
+parse_list(const char* text, u32* out, b8 (*parse)(const char*, u32*))
+{
+    char buffer[256];
+    strncpy(buffer, text, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+
+    u32 count = 0;
+    for (char* item = strtok(buffer, ","); item != NULL && count < BENCH_MAX_ITEMS; item = strtok(NULL, ","))
+    {
+        if (parse(item, &out[count]) == 0)
+        {
+            fprintf(stderr, "Invalid value: %s\n", item);
+            return 0;
+        }
+        count += 1;
+    }
+
+    return count;
+}
+
+static b8
+parse_number(const char* text, u32* out)
+{
+    char* end = NULL;
+    unsigned long value = strtoul(text, &end, 10);
+    *out = (u32)value;
+
+    return end != text && *end == '\0';
+}
+
+static b8
+parse_algo(const char* text, u32* out)
+{
+    *out = searchAlgoFromName(text);
+
+    return *out != ALGO_NONE;
+}
+
+static b8
+parse_queue(const char* text, u32* out)
+{
+    *out = pqKindFromName(text);
+
+    return *out != PQ_COUNT;
+}
+
+static b8
+parse_weights(const char* text, u32* out)
+{
+    for (u32 i = 0; i < WEIGHTS_COUNT; ++i)
+    {
+        if (strcmp(text, g_weight_names[i]) == 0)
+        {
+            *out = i;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void
+print_usage(const char* program)
+{
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "\n"
+        "Options:\n"
+        "  --sizes <n,...>       grid side lengths (default: 32,128,512,2048)\n"
+        "  --densities <p,...>   wall percentages (default: 0,10,20,30)\n"
+        "  --weights <w,...>     unit, uniform, skewed (default: all)\n"
+        "  --algos <a,...>       bfs, dfs, dijkstra, astar, jps, jps+, bfs-bi, dijkstra-bi,\n"
+        "                        astar-bi, lpastar, hpa, bfs-par, delta, astar-alt (default: all)\n"
+        "  --queues <q,...>      heap, bucket, radix, dary for the weighted searches (default: all)\n"
+        "  --repeat <n>          runs per configuration, the fastest is kept (default: 3)\n"
+        "  --batch <n>           run n random queries per map on a thread pool instead\n"
+        "                        (bfs, dijkstra and astar only)\n"
+        "  --threads <n,...>     worker counts for --batch, bfs-par and delta (default: 1 and one per core)\n"
+        "  --delta <n>           bucket width of delta, 0 for the largest weight (default: 0)\n"
+        "  --connectivity <n>    4, or 8 for diagonal moves; searches without them are skipped (default: 4)\n"
+        "  --landmarks <n>       landmarks placed by astar-alt, 1 to 64 (default: 8)\n"
+        "  --seed <n>            map generator seed (default: 1)\n"
+        "  -o, --output <file>   write the results as CSV\n",
+        program);
+}
+
+static b8
+parse_args(int argc, char** argv, BenchConfig* config)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* option = argv[i];
+        const char* value  = i + 1 < argc ? argv[i + 1] : NULL;
+        if (value == NULL) return 0;
+        ++i;
+
+        if      (strcmp(option, "--sizes") == 0)        config->size_count    = parse_list(value, config->sizes, parse_number);
+        else if (strcmp(option, "--densities") == 0)    config->density_count = parse_list(value, config->densities, parse_number);
+        else if (strcmp(option, "--weights") == 0)      config->weight_count  = parse_list(value, config->weights, parse_weights);
+        else if (strcmp(option, "--algos") == 0)        config->algo_count    = parse_list(value, config->algos, parse_algo);
+        else if (strcmp(option, "--queues") == 0)       config->queue_count   = parse_list(value, config->queues, parse_queue);
+        else if (strcmp(option, "--repeat") == 0)       config->repeat        = (u32)strtoul(value, NULL, 10);
+        else if (strcmp(option, "--batch") == 0)        config->batch         = (u32)strtoul(value, NULL, 10);
+        else if (strcmp(option, "--threads") == 0)      config->thread_count  = parse_list(value, config->threads, parse_number);
+        else if (strcmp(option, "--delta") == 0)        config->delta         = (u32)strtoul(value, NULL, 10);
+        else if (strcmp(option, "--connectivity") == 0) config->connectivity  = (u32)strtoul(value, NULL, 10);
+        else if (strcmp(option, "--landmarks") == 0)    config->landmarks     = (u32)strtoul(value, NULL, 10);
+        else if (strcmp(option, "--seed") == 0)         config->seed          = strtoull(value, NULL, 10);
+        else if (strcmp(option, "-o") == 0 || strcmp(option, "--output") == 0) config->output = value;
+        else return 0;
+    }
+
+    for (u32 i = 0; i < config->size_count; ++i)
+    {
+        if (config->sizes[i] < 2 || (u64)config->sizes[i] * config->sizes[i] > GRID_MAX_CELLS)
+        {
+            fprintf(stderr, "Grid sizes must be at least 2 and hold at most %u cells\n", GRID_MAX_CELLS);
+            return 0;
+        }
+    }
+
+    for (u32 i = 0; i < config->thread_count; ++i)
+    {
+        if (config->threads[i] == 0 || config->threads[i] > 256)
+        {
+            fprintf(stderr, "Thread counts must be between 1 and 256\n");
+            return 0;
+        }
+    }
+
+    for (u32 i = 0; i < config->density_count; ++i)
+    {
+        if (config->densities[i] > 90)
+        {
+            fprintf(stderr, "Wall densities must be at most 90%%\n");
+            return 0;
+        }
+    }
+
+    if (config->connectivity != GRID_CONNECT_4 && config->connectivity != GRID_CONNECT_8)
+    {
+        fprintf(stderr, "Connectivity must be 4 or 8\n");
+        return 0;
+    }
+
+    if (config->landmarks == 0 || config->landmarks > LANDMARKS_MAX_COUNT)
+    {
+        fprintf(stderr, "Landmark counts must be between 1 and %u\n", LANDMARKS_MAX_COUNT);
+        return 0;
+    }
+
+    return config->size_count > 0 && config->density_count > 0 &&
+           config->weight_count > 0 && config->algo_count > 0 && config->queue_count > 0 &&
+           config->repeat > 0;
+}
+
+// Random start and goal on open cells of the current grid
+static void
+generate_queries(SearchQuery* queries, u32 count, u64 seed)
+{
+    Grid* grid = gridGet();
+    u64   rng  = seed * 0xD1B54A32D192ED03ull + 1;
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        u32 cells[2];
+        for (u32 k = 0; k < 2; ++k)
+        {
+            do cells[k] = xorshift64(&rng) % gridGetCellCount();
+            while (gridIsWall(grid, cells[k]) == 1);
+        }
+
+        queries[i] = (SearchQuery){ .start = cells[0], .goal = cells[1] };
+    }
+}
+
+// Throughput of searchBatchRun() per worker count, the speedup is relative to the first count
+static void
+run_batch(const BenchConfig* config, FILE* csv)
+{
+    if (csv != NULL)
+    {
+        fprintf(csv, "algorithm,queue,size,cells,density,weights,threads,queries,found,cost_sum,"
+                     "time_ns,queries_per_sec,speedup\n");
+    }
+
+    printf("%-12s %-6s %6s %4s %-8s %7s %8s %8s %14s %12s %12s %8s\n",
+           "algorithm", "queue", "size", "wall", "weights", "threads", "queries", "found",
+           "cost_sum", "time_ms", "queries/s", "speedup");
+
+    SearchQuery*  queries = malloc(config->batch * sizeof(SearchQuery));
+    SearchResult* results = malloc(config->batch * sizeof(SearchResult));
+
+    for (u32 s = 0; s < config->size_count; ++s)
+    {
+        for (u32 d = 0; d < config->density_count; ++d)
+        {
+            for (u32 w = 0; w < config->weight_count; ++w)
+            {
+                u32 size    = config->sizes[s];
+                u32 density = config->densities[d];
+
+                generate_grid(size, density, config->weights[w], config->seed);
+                generate_queries(queries, config->batch, config->seed);
+
+                for (u32 a = 0; a < config->algo_count; ++a)
+                {
+                    SearchAlgo algo       = config->algos[a];
+                    b8         uses_queue = algo != ALGO_BFS;
+
+                    if (algo != ALGO_BFS && algo != ALGO_DIJKSTRA && algo != ALGO_ASTAR) continue;
+
+                    for (u32 q = 0; q < (uses_queue ? config->queue_count : 1); ++q)
+                    {
+                        PriorityQueueKind queue      = uses_queue ? config->queues[q] : SEARCH_QUEUE_AUTO;
+                        const char*       queue_name = uses_queue ? pqKindName(queue) : "-";
+                        u64               baseline   = 0;
+
+                        for (u32 t = 0; t < config->thread_count; ++t)
+                        {
+                            u32 threads = config->threads[t];
+                            u64 best_ns = UINT64_MAX;
+
+                            for (u32 r = 0; r < config->repeat; ++r)
+                            {
+                                u64 begin = timerNowNs();
+                                searchBatchRun(algo, queue, queries, config->batch, results, threads);
+
+                                u64 elapsed = timerNowNs() - begin;
+                                if (elapsed < best_ns) best_ns = elapsed;
+                            }
+
+                            u64 found    = 0;
+                            u64 cost_sum = 0;
+                            for (u32 i = 0; i < config->batch; ++i)
+                            {
+                                found    += results[i].found;
+                                cost_sum += results[i].path_cost;
+                            }
+
+                            if (t == 0) baseline = best_ns;
+
+                            double per_second = best_ns > 0 ? config->batch / (best_ns / 1e9) : 0.0;
+                            double speedup    = best_ns > 0 ? (double)baseline / best_ns : 0.0;
+
+                            printf("%-12s %-6s %6u %3u%% %-8s %7u %8u %8lu %14lu %12.3f %12.0f %7.2fx\n",
+                                   searchAlgoName(algo), queue_name, size, density,
+                                   g_weight_names[config->weights[w]], threads, config->batch, found,
+                                   cost_sum, best_ns / 1e6, per_second, speedup);
+
+                            if (csv != NULL)
+                            {
+                                fprintf(csv, "%s,%s,%u,%lu,%u,%s,%u,%u,%lu,%lu,%lu,%.0f,%.3f\n",
+                                        searchAlgoName(algo), queue_name, size, (u64)size * size, density,
+                                        g_weight_names[config->weights[w]], threads, config->batch, found,
+                                        cost_sum, best_ns, per_second, speedup);
+                            }
+                        }
+                    }
+                }
+
+                gridDestroy();
+            }
+        }
+    }
+
+    free(results);
+    free(queries);
+}
+
+int main(int argc, char** argv)
+{
+    BenchConfig config = {
+        .sizes          = { 32, 128, 512, 2048 },
+        .size_count     = 4,
+        .densities      = { 0, 10, 20, 30 },
+        .density_count  = 4,
+        .weights        = { WEIGHTS_UNIT, WEIGHTS_UNIFORM, WEIGHTS_SKEWED },
+        .weight_count   = 3,
+        .algos          = { ALGO_BFS, ALGO_DFS, ALGO_DIJKSTRA, ALGO_ASTAR, ALGO_JPS, ALGO_JPS_PLUS,
+                            ALGO_BFS_BIDIR, ALGO_DIJKSTRA_BIDIR, ALGO_ASTAR_BIDIR, ALGO_LPA_STAR,
+                            ALGO_HPA, ALGO_BFS_PARALLEL, ALGO_DELTA_STEPPING, ALGO_ASTAR_ALT },
+        .algo_count     = 14,
+        .queues         = { PQ_BINARY_HEAP, PQ_BUCKET, PQ_RADIX, PQ_DARY },
+        .queue_count    = 4,
+        .thread_count   = 0,
+        .batch          = 0,
+        .delta          = 0,
+        .connectivity   = GRID_CONNECT_4,
+        .landmarks      = LANDMARKS_DEFAULT_COUNT,
+        .repeat         = 3,
+        .seed           = 1,
+        .output         = NULL
+    };
+
+    if (parse_args(argc, argv, &config) == 0)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if (config.thread_count == 0)
+    {
+        config.threads[config.thread_count++] = 1;
+
+        u32 cores = searchBatchDefaultThreads();
+        if (cores > 1) config.threads[config.thread_count++] = cores;
+    }
+
+    searchSetDelta(config.delta);
+    gridSetConnectivity(config.connectivity);
+    landmarksSetCount(config.landmarks);
+
+    FILE* csv = NULL;
+    if (config.output != NULL)
+    {
+        csv = fopen(config.output, "w");
+        if (csv == NULL)
+        {
+            fprintf(stderr, "Could not open %s\n", config.output);
+            return 1;
+        }
+    }
+
+    LoggerConfig logger_config = getDefaultLoggerConfig();
+    logger_config.out = LOG_OUTPUT_CONSOLE;
+    loggerInit(&logger_config);
+
+    if (config.batch > 0)
+    {
+        run_batch(&config, csv);
+
+        if (csv != NULL) fclose(csv);
+        loggerTerminate();
+
+        return 0;
+    }
+
+    if (csv != NULL)
+    {
+        fprintf(csv, "algorithm,queue,threads,size,cells,density,weights,found,path_length,path_cost,"
+                     "expanded,time_ns,expanded_per_sec,ns_per_expansion,peak_frontier,"
+                     "stale_pops,search_bytes,peak_rss_kb,cost_excess_pct,pushes,init_ns,search_ns,path_ns\n");
+    }
+
+    printf("%-12s %-6s %3s %6s %4s %-8s %5s %10s %8s %12s %12s %12s %10s %12s %10s %10s\n",
+           "algorithm", "queue", "thr", "size", "wall", "weights", "found", "cost", "excess", "expanded",
+           "pushes", "exp/s", "ns/exp", "peak_front", "stale", "rss_kb");
+
+    for (u32 s = 0; s < config.size_count; ++s)
+    {
+        for (u32 d = 0; d < config.density_count; ++d)
+        {
+            for (u32 w = 0; w < config.weight_count; ++w)
+            {
+                u32 size    = config.sizes[s];
+                u32 density = config.densities[d];
+                u64 cells   = (u64)size * size;
+
+                generate_grid(size, density, config.weights[w], config.seed);
+
+                // Optimal cost of the map, to measure how much longer the paths of HPA* are
+                u64 optimal_cost = searchRun(ALGO_ASTAR).path_cost;
+
+                for (u32 a = 0; a < config.algo_count; ++a)
+                {
+                    SearchAlgo algo       = config.algos[a];
+                    if (config.connectivity == GRID_CONNECT_8 && searchResolveAlgo(algo) != algo) continue;
+
+                    b8         uses_queue = algo != ALGO_BFS && algo != ALGO_DFS && algo != ALGO_BFS_BIDIR &&
+                                            algo != ALGO_LPA_STAR && algo != ALGO_BFS_PARALLEL &&
+                                            algo != ALGO_DELTA_STEPPING;
+                    b8         threaded   = algo == ALGO_BFS_PARALLEL || algo == ALGO_DELTA_STEPPING;
+
+                    // One run per queue, or per thread count for the parallel searches
+                    u32 variants = uses_queue ? config.queue_count : threaded ? config.thread_count : 1;
+
+                    for (u32 v = 0; v < variants; ++v)
+                    {
+                        const char* queue_name = uses_queue ? pqKindName(config.queues[v]) : "-";
+                        u32         threads    = threaded ? config.threads[v] : 1;
+
+                        if (uses_queue) searchSetQueue(config.queues[v]);
+                        if (threaded)   searchSetThreads(threads);
+
+                        SearchResult best   = {0};
+                        u64          rss_kb = 0;
+                        if (run_isolated(algo, config.repeat, &best, &rss_kb) == 0) continue;
+
+                        u64    expanded     = best.stats.expanded;
+                        double seconds      = best.elapsed_ns / 1e9;
+                        double per_second   = seconds > 0 ? expanded / seconds : 0.0;
+                        double ns_per_exp   = expanded > 0 ? (double)best.elapsed_ns / expanded : 0.0;
+                        u64    search_bytes = gridGetMemoryBytes() + best.stats.peak_frontier * sizeof(PQEntry);
+                        if (algo == ALGO_ASTAR_ALT) search_bytes += landmarksGetMemoryBytes();
+                        double excess       = best.found && optimal_cost > 0
+                            ? 100.0 * ((double)best.path_cost - optimal_cost) / optimal_cost
+                            : 0.0;
+
+                        printf("%-12s %-6s %3u %6u %3u%% %-8s %5s %10lu %7.2f%% %12lu %12lu %12.0f %10.1f %12lu %10lu %10lu\n",
+                               searchAlgoName(algo), queue_name, threads, size, density,
+                               g_weight_names[config.weights[w]], best.found ? "yes" : "no",
+                               best.path_cost, excess, expanded, best.stats.pushes, per_second, ns_per_exp,
+                               best.stats.peak_frontier, best.stats.stale_pops, rss_kb);
+
+                        if (csv != NULL)
+                        {
+                            fprintf(csv, "%s,%s,%u,%u,%lu,%u,%s,%u,%u,%lu,%lu,%lu,%.0f,%.2f,%lu,%lu,%lu,%lu,%.3f,%lu,%lu,%lu,%lu\n",
+                                    searchAlgoName(algo), queue_name, threads, size, cells, density,
+                                    g_weight_names[config.weights[w]], best.found, best.path_length,
+                                    best.path_cost, expanded, best.elapsed_ns, per_second, ns_per_exp,
+                                    best.stats.peak_frontier, best.stats.stale_pops, search_bytes, rss_kb, excess,
+                                    best.stats.pushes, best.init_ns, best.search_ns, best.path_ns);
+                        }
+                    }
+                }
+
+                gridDestroy();
+            }
+        }
+    }
+
+    if (csv != NULL) fclose(csv);
+    loggerTerminate();
+
+    return 0;
+}
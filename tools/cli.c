@@ -0,0 +1,335 @@
+#include "logger.h"
+
+#include "grid.h"
+#include "landmarks.h"
+#include "map_io.h"
+#include "search.h"
+#include "search_path.h"
+#include "priority_queue.h"
+#include "timer.h"
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void
+print_usage(const char* program)
+{
+    fprintf(stderr,
+        "Usage: %s <map> [options]\n"
+        "\n"
+        "Options:\n"
+        "  -a, --algo <name>     bfs, dfs, dijkstra, astar, jps, jps+, bfs-bi,\n"
+        "                        dijkstra-bi, astar-bi, lpastar, hpa, bfs-par, delta, astar-alt\n"
+        "                        or all (default: all)\n"
+        "  -s, --start <r,c>     override the start cell of the map\n"
+        "  -g, --goal <r,c>      override the goal cell of the map\n"
+        "  -q, --queue <name>    weighted search queue: heap, bucket, radix, dary or auto (default: auto)\n"
+        "  -t, --threads <n>     threads of bfs-par and delta, 0 for one per core (default: 0)\n"
+        "  -d, --delta <n>       bucket width of delta, 0 for the largest weight (default: 0)\n"
+        "  -c, --connectivity <n> 4, or 8 to allow diagonal moves; costs are then counted\n"
+        "                        in units of 1/408 of a straight step (default: 4)\n"
+        "  -k, --landmark-count <n> landmarks placed by astar-alt, 1 to 64 (default: 8)\n"
+        "  -l, --landmarks <file> landmark tables of astar-alt (.pflm): loaded when they were\n"
+        "                        built for this map and count, built and saved otherwise\n"
+        "  -j, --json            print the results as a JSON array, one object per algorithm\n"
+        "  -w, --waypoints       string pull each path found into any-angle waypoints and print\n"
+        "                        their count and length (to stderr with --json)\n"
+        "  -r, --trace <file>    record the events of a single --algo to a .pftrace file for\n"
+        "                        pathfinder_replay (needs a build with PATHFINDER_TRACE)\n"
+        "      --trace-events <n> events kept by --trace, the oldest are dropped beyond it\n"
+        "                        (default: 1048576)\n"
+        "  -o, --output <file>   save the map (after --start/--goal) in the format of its extension\n"
+        "\n"
+        "Map formats: .map (MovingAI), .pfmap (binary, memory-mapped) or ASCII with one\n"
+        "line per row, '.' open, '#' wall, 'S' start, 'G' goal, '1'-'9' weight\n",
+        program);
+}
+
+static b8
+parse_cell(const char* text, u32* row, u32* col)
+{
+    return sscanf(text, "%u,%u", row, col) == 2 && *row < gridGetRows() && *col < gridGetCols();
+}
+
+static void
+print_result(SearchAlgo algo, SearchResult result)
+{
+    if (result.found == 0)
+    {
+        printf("%-12s %-6s %10s %12s %12.3f %12lu %12lu %10lu\n", searchAlgoName(algo), "no", "-", "-",
+               result.elapsed_ns / 1e6, result.stats.expanded, result.stats.pushes, result.stats.stale_pops);
+        return;
+    }
+
+    printf("%-12s %-6s %10u %12lu %12.3f %12lu %12lu %10lu\n", searchAlgoName(algo), "yes",
+           result.path_length, result.path_cost, result.elapsed_ns / 1e6,
+           result.stats.expanded, result.stats.pushes, result.stats.stale_pops);
+}
+
+// Extracts the path of the last search and pulls it into waypoints
+static void
+print_waypoints(SearchAlgo algo, SearchPath* path, SearchPath* waypoints, FILE* out)
+{
+    const Grid* grid = gridGet();
+
+    searchGetPath(path);
+
+    u64 begin = timerNowNs();
+    searchPathSmooth(grid, path, waypoints);
+    u64 elapsed_ns = timerNowNs() - begin;
+
+    fprintf(out, "%-12s %u cells, length %.2f -> %u waypoints, length %.2f in %.3f ms\n", searchAlgoName(algo),
+            path->count, searchPathLength(grid, path), waypoints->count, searchPathLength(grid, waypoints),
+            elapsed_ns / 1e6);
+}
+
+static void
+print_json(SearchAlgo algo, SearchResult result, b8 is_first)
+{
+    char json[512];
+    searchResultToJson(algo, &result, json, sizeof(json));
+
+    printf("%s  %s", is_first == 1 ? "" : ",\n", json);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    LoggerConfig config = getDefaultLoggerConfig();
+    config.out = LOG_OUTPUT_CONSOLE;
+    loggerInit(&config);
+
+    const char* map_path       = argv[1];
+    const char* algo_name      = "all";
+    const char* start_text     = NULL;
+    const char* goal_text      = NULL;
+    const char* queue_name     = "auto";
+    const char* output_path    = NULL;
+    const char* landmarks_path = NULL;
+    const char* trace_path     = NULL;
+    u32         connectivity   = GRID_CONNECT_4;
+    b8          json           = 0;
+    b8          smooth         = 0;
+
+    for (int i = 2; i < argc; ++i)
+    {
+        if ((strcmp(argv[i], "-a") == 0 || strcmp(argv[i], "--algo") == 0) && i + 1 < argc)
+            algo_name = argv[++i];
+        else if ((strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "--start") == 0) && i + 1 < argc)
+            start_text = argv[++i];
+        else if ((strcmp(argv[i], "-g") == 0 || strcmp(argv[i], "--goal") == 0) && i + 1 < argc)
+            goal_text = argv[++i];
+        else if ((strcmp(argv[i], "-q") == 0 || strcmp(argv[i], "--queue") == 0) && i + 1 < argc)
+            queue_name = argv[++i];
+        else if ((strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "--threads") == 0) && i + 1 < argc)
+            searchSetThreads((u32)strtoul(argv[++i], NULL, 10));
+        else if ((strcmp(argv[i], "-d") == 0 || strcmp(argv[i], "--delta") == 0) && i + 1 < argc)
+            searchSetDelta((u32)strtoul(argv[++i], NULL, 10));
+        else if ((strcmp(argv[i], "-c") == 0 || strcmp(argv[i], "--connectivity") == 0) && i + 1 < argc)
+            connectivity = (u32)strtoul(argv[++i], NULL, 10);
+        else if ((strcmp(argv[i], "-k") == 0 || strcmp(argv[i], "--landmark-count") == 0) && i + 1 < argc)
+            landmarksSetCount((u32)strtoul(argv[++i], NULL, 10));
+        else if ((strcmp(argv[i], "-l") == 0 || strcmp(argv[i], "--landmarks") == 0) && i + 1 < argc)
+            landmarks_path = argv[++i];
+        else if ((strcmp(argv[i], "-r") == 0 || strcmp(argv[i], "--trace") == 0) && i + 1 < argc)
+            trace_path = argv[++i];
+        else if (strcmp(argv[i], "--trace-events") == 0 && i + 1 < argc)
+            traceSetCapacity(strtoull(argv[++i], NULL, 10));
+        else if (strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--json") == 0)
+            json = 1;
+        else if (strcmp(argv[i], "-w") == 0 || strcmp(argv[i], "--waypoints") == 0)
+            smooth = 1;
+        else if ((strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--output") == 0) && i + 1 < argc)
+            output_path = argv[++i];
+        else
+        {
+            print_usage(argv[0]);
+            loggerTerminate();
+            return 1;
+        }
+    }
+
+    if (strcmp(queue_name, "auto") != 0)
+    {
+        PriorityQueueKind queue = pqKindFromName(queue_name);
+        if (queue == PQ_COUNT)
+        {
+            fprintf(stderr, "Unknown queue: %s\n", queue_name);
+            loggerTerminate();
+            return 1;
+        }
+        searchSetQueue(queue);
+    }
+
+    if (trace_path != NULL && TRACE_ENABLED == 0)
+    {
+        fprintf(stderr, "Tracing is not compiled in, configure with -DPATHFINDER_TRACE=ON\n");
+        loggerTerminate();
+        return 1;
+    }
+
+    if (connectivity != GRID_CONNECT_4 && connectivity != GRID_CONNECT_8)
+    {
+        fprintf(stderr, "Connectivity must be 4 or 8\n");
+        loggerTerminate();
+        return 1;
+    }
+    gridSetConnectivity(connectivity);
+
+    if (mapLoadAny(map_path) == 0)
+    {
+        loggerTerminate();
+        return 1;
+    }
+
+    u32 row = 0;
+    u32 col = 0;
+
+    if (start_text != NULL)
+    {
+        if (parse_cell(start_text, &row, &col) == 0)
+        {
+            fprintf(stderr, "Invalid start cell: %s\n", start_text);
+            gridDestroy();
+            loggerTerminate();
+            return 1;
+        }
+        gridSetStart(row, col);
+    }
+
+    if (goal_text != NULL)
+    {
+        if (parse_cell(goal_text, &row, &col) == 0)
+        {
+            fprintf(stderr, "Invalid goal cell: %s\n", goal_text);
+            gridDestroy();
+            loggerTerminate();
+            return 1;
+        }
+        gridSetGoal(row, col);
+    }
+
+    // Converting a map needs no start or goal
+    if (output_path != NULL)
+    {
+        b8 saved = mapSaveAny(output_path);
+        if (saved == 1) printf("saved %s: %u x %u\n", output_path, gridGetRows(), gridGetCols());
+
+        if (saved == 0 || gridGetStart() == GRID_NO_CELL || gridGetGoal() == GRID_NO_CELL)
+        {
+            gridDestroy();
+            loggerTerminate();
+            return saved == 1 ? 0 : 1;
+        }
+    }
+
+    if (gridGetStart() == GRID_NO_CELL || gridGetGoal() == GRID_NO_CELL)
+    {
+        fprintf(stderr, "The map needs a start and a goal (use 'S'/'G' or --start/--goal)\n");
+        gridDestroy();
+        loggerTerminate();
+        return 1;
+    }
+
+    SearchAlgo only = ALGO_NONE;
+    if (strcmp(algo_name, "all") != 0)
+    {
+        only = searchAlgoFromName(algo_name);
+        if (only == ALGO_NONE)
+        {
+            fprintf(stderr, "Unknown algorithm: %s\n", algo_name);
+            gridDestroy();
+            loggerTerminate();
+            return 1;
+        }
+    }
+
+    // One buffer holds the events of one search
+    if (trace_path != NULL && only == ALGO_NONE)
+    {
+        fprintf(stderr, "--trace needs a single --algo\n");
+        gridDestroy();
+        loggerTerminate();
+        return 1;
+    }
+
+    // Tables built here are timed apart from the searches, like a preprocessing step
+    if (landmarks_path != NULL && (only == ALGO_NONE || only == ALGO_ASTAR_ALT))
+    {
+        // Reported on stderr with --json, so stdout stays a single document
+        FILE* out = json == 1 ? stderr : stdout;
+
+        if (landmarksLoad(landmarks_path) == 1)
+        {
+            fprintf(out, "loaded %u landmarks from %s\n", landmarksPrepare()->count, landmarks_path);
+        }
+        else if (landmarksSave(landmarks_path) == 1)
+        {
+            fprintf(out, "saved %u landmarks to %s\n", landmarksPrepare()->count, landmarks_path);
+        }
+    }
+
+    if (json == 1)
+    {
+        printf("[\n");
+    }
+    else
+    {
+        printf("map %s: %u x %u\n", map_path, gridGetRows(), gridGetCols());
+        printf("%-12s %-6s %10s %12s %12s %12s %12s %10s\n", "algorithm", "found", "length", "cost", "time_ms",
+               "expanded", "pushes", "stale");
+    }
+
+    // Reused by every search, so only the first path allocates
+    SearchPath path      = {0};
+    SearchPath waypoints = {0};
+
+    b8 is_first = 1;
+    for (u32 algo = ALGO_NONE + 1; algo < ALGO_COUNT; ++algo)
+    {
+        if (only != ALGO_NONE && algo != only) continue;
+        // Searches without diagonal moves would only repeat the ones they fall back to
+        if (only == ALGO_NONE && connectivity == GRID_CONNECT_8 && searchResolveAlgo(algo) != algo) continue;
+
+        SearchResult result = searchRun(algo);
+
+        if (json == 1) print_json(algo, result, is_first);
+        else           print_result(algo, result);
+
+        if (smooth == 1 && result.found == 1) print_waypoints(algo, &path, &waypoints, json == 1 ? stderr : stdout);
+
+        is_first = 0;
+    }
+
+    if (json == 1) printf("\n]\n");
+
+    if (trace_path != NULL && traceGetRecorded() == 0)
+    {
+        fprintf(stderr, "%s records no trace events, only bfs, dfs, dijkstra, astar and astar-alt do\n", algo_name);
+    }
+    else if (trace_path != NULL && traceSave(trace_path) == 1)
+    {
+        FILE* out      = json == 1 ? stderr : stdout;
+        u64   recorded = traceGetRecorded();
+        u64   capacity = traceGetCapacity();
+
+        fprintf(out, "saved %lu events to %s\n", recorded < capacity ? recorded : capacity, trace_path);
+        if (recorded > capacity) fprintf(out, "dropped the first %lu, raise --trace-events to keep them\n", recorded - capacity);
+    }
+
+    searchPathFree(&path);
+    searchPathFree(&waypoints);
+    traceDestroy();
+    landmarksDestroy();
+    gridDestroy();
+    loggerTerminate();
+
+    return 0;
+}
@@ -0,0 +1,332 @@
+#include "logger.h"
+
+#include "grid.h"
+#include "grid_neighbors.h"
+#include "landmarks.h"
+#include "map_io.h"
+#include "search.h"
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct ReplayConfig
+{
+    const char* trace_path;
+    const char* map_path;       // NULL: replay without checking against a map
+    u64         event_limit;    // events to replay, UINT64_MAX for all
+    b8          print;
+} ReplayConfig;
+
+// The search as rebuilt from its events
+typedef struct Replay
+{
+    u32*    parent;
+    u8*     expanded;           // 1 once a cell was popped
+
+    u64     counts[TRACE_KIND_COUNT];
+    u64     expanded_count;
+    u64     stale_pops;
+    u64     replayed;
+
+    u32     current;            // the cell of the last pop, the parent of the cells relaxed after it
+    u32     path_length;
+    b8      found;
+    u32     goal_distance;
+} Replay;
+
+static void
+print_usage(const char* program)
+{
+    fprintf(stderr,
+        "Usage: %s <file.pftrace> [options]\n"
+        "\n"
+        "Rebuilds a search from a trace recorded by pathfinder_cli --trace: the\n"
+        "expansion order, the parent of every reached cell and the path to the goal.\n"
+        "\n"
+        "Options:\n"
+        "  -n, --events <n>      replay only the first n events, to see the search at that point\n"
+        "  -p, --print           print every replayed event\n"
+        "  -m, --map <file>      the map the trace was recorded on: checks that the path\n"
+        "                        moves between open neighbors and reruns the search to\n"
+        "                        compare its counters with the trace\n",
+        program);
+}
+
+static b8
+parse_args(int argc, char** argv, ReplayConfig* config)
+{
+    if (argc < 2) return 0;
+    config->trace_path = argv[1];
+
+    for (int i = 2; i < argc; ++i)
+    {
+        if      ((strcmp(argv[i], "-n") == 0 || strcmp(argv[i], "--events") == 0) && i + 1 < argc)
+            config->event_limit = strtoull(argv[++i], NULL, 10);
+        else if ((strcmp(argv[i], "-m") == 0 || strcmp(argv[i], "--map") == 0) && i + 1 < argc)
+            config->map_path = argv[++i];
+        else if (strcmp(argv[i], "-p") == 0 || strcmp(argv[i], "--print") == 0)
+            config->print = 1;
+        else
+            return 0;
+    }
+
+    return 1;
+}
+
+// Applies the events in order. Returns 0 at the first event that names a
+// cell outside the grid or relaxes a cell before anything was popped.
+static b8
+replay_events(const Trace* trace, const ReplayConfig* config, Replay* replay)
+{
+    u64 cell_count = (u64)trace->rows * trace->cols;
+    u64 limit      = config->event_limit < trace->count ? config->event_limit : trace->count;
+    b8  complete   = trace->recorded == trace->count;
+
+    replay->current = GRID_NO_CELL;
+    for (u64 i = 0; i < cell_count; ++i) replay->parent[i] = GRID_NO_CELL;
+
+    for (u64 i = 0; i < limit; ++i)
+    {
+        TraceEvent event = trace->events[i];
+        u64        index = trace->recorded - trace->count + i;
+
+        if (event.kind >= TRACE_KIND_COUNT || event.cell >= cell_count)
+        {
+            fprintf(stderr, "event %lu: invalid %s of cell %u\n", index, traceKindName(event.kind), event.cell);
+            return 0;
+        }
+
+        if (config->print == 1)
+        {
+            printf("%10lu %-6s %6u,%-6u %u\n", index, traceKindName(event.kind),
+                   event.cell / trace->cols, event.cell % trace->cols, event.value);
+        }
+
+        replay->counts[event.kind] += 1;
+        replay->replayed           += 1;
+
+        switch (event.kind)
+        {
+            case TRACE_POP:
+                // Lazy deletion leaves outdated entries behind, the first pop of a cell expands it
+                if (replay->expanded[event.cell] == 1)
+                {
+                    replay->stale_pops += 1;
+                    break;
+                }
+                replay->expanded[event.cell] = 1;
+                replay->expanded_count      += 1;
+                replay->current              = event.cell;
+                break;
+
+            case TRACE_RELAX:
+                // Only a trace whose first events were dropped relaxes before the first pop
+                if (replay->current == GRID_NO_CELL && complete == 1)
+                {
+                    fprintf(stderr, "event %lu: cell %u relaxed before the first pop\n", index, event.cell);
+                    return 0;
+                }
+                replay->parent[event.cell] = replay->current;
+                break;
+
+            case TRACE_GOAL:
+                replay->found         = 1;
+                replay->goal_distance = event.value;
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    if (replay->found == 0) return 1;
+
+    for (u32 cell = trace->goal; cell != GRID_NO_CELL && replay->path_length <= cell_count; cell = replay->parent[cell])
+    {
+        replay->path_length += 1;
+    }
+
+    return 1;
+}
+
+// Walks the replayed path on the map. Returns 0 when a step jumps between
+// cells that aren't neighbors or enters a wall.
+static b8
+check_path(const Trace* trace, const Replay* replay, u64* path_cost)
+{
+    const Grid* grid = gridGet();
+    *path_cost = 0;
+
+    for (u32 cell = trace->goal; cell != trace->start; cell = replay->parent[cell])
+    {
+        u32 parent = replay->parent[cell];
+        if (parent == GRID_NO_CELL)
+        {
+            fprintf(stderr, "path: %u,%u has no parent\n", cell / grid->cols, cell % grid->cols);
+            return 0;
+        }
+
+        i64 row_step = (i64)(cell / grid->cols) - (i64)(parent / grid->cols);
+        i64 col_step = (i64)(cell % grid->cols) - (i64)(parent % grid->cols);
+        b8  diagonal = row_step != 0 && col_step != 0;
+
+        if (row_step < -1 || row_step > 1 || col_step < -1 || col_step > 1 || gridIsWall(grid, cell) == 1 ||
+            (diagonal == 1 && grid->connectivity != GRID_CONNECT_8))
+        {
+            fprintf(stderr, "path: no move from %u,%u to %u,%u\n",
+                    parent / grid->cols, parent % grid->cols, cell / grid->cols, cell % grid->cols);
+            return 0;
+        }
+
+        *path_cost += gridStepCost(grid, parent, cell);
+    }
+
+    return 1;
+}
+
+static b8
+check_counter(const char* name, u64 replayed, u64 live)
+{
+    if (replayed == live) return 1;
+
+    fprintf(stderr, "%s: %lu in the trace, %lu when rerun\n", name, replayed, live);
+    return 0;
+}
+
+// Reruns the traced search on the map and compares it with the replay
+static b8
+check_map(const Trace* trace, const ReplayConfig* config, const Replay* replay)
+{
+    gridSetConnectivity(trace->connectivity);
+    if (mapLoadAny(config->map_path) == 0) return 0;
+
+    if (gridGetRows() != trace->rows || gridGetCols() != trace->cols)
+    {
+        fprintf(stderr, "%s is %u x %u, the trace was recorded on %u x %u\n", config->map_path,
+                gridGetRows(), gridGetCols(), trace->rows, trace->cols);
+        return 0;
+    }
+
+    // The path of a trace whose first events were dropped may not reach the start
+    if (trace->recorded > trace->count)
+    {
+        printf("rerun         skipped, the trace is incomplete\n");
+        return 1;
+    }
+
+    b8  valid     = 1;
+    u64 path_cost = 0;
+
+    if (replay->found == 1)
+    {
+        valid = check_path(trace, replay, &path_cost);
+        if (valid == 1) printf("path cost     %lu on %s\n", path_cost, config->map_path);
+    }
+
+    // A partial replay has nothing to compare the finished search with
+    if (replay->replayed < trace->recorded) return valid;
+
+    gridSetStart(trace->start / trace->cols, trace->start % trace->cols);
+    gridSetGoal(trace->goal / trace->cols, trace->goal % trace->cols);
+    searchSetQueue(trace->queue);
+    landmarksSetCount(trace->landmark_count);
+
+    SearchResult result = searchRun(trace->algo);
+
+    valid = check_counter("found", replay->found, result.found) && valid;
+    valid = check_counter("expanded", replay->expanded_count, result.stats.expanded) && valid;
+    valid = check_counter("pushes", replay->counts[TRACE_PUSH], result.stats.pushes) && valid;
+    valid = check_counter("stale pops", replay->stale_pops, result.stats.stale_pops) && valid;
+
+    if (replay->found == 1 && result.found == 1)
+    {
+        valid = check_counter("path length", replay->path_length, result.path_length) && valid;
+        valid = check_counter("path cost", path_cost, result.path_cost) && valid;
+    }
+
+    printf("rerun         %s\n", valid == 1 ? "matches the trace" : "differs from the trace");
+
+    return valid;
+}
+
+int main(int argc, char** argv)
+{
+    ReplayConfig config = {
+        .trace_path     = NULL,
+        .map_path       = NULL,
+        .event_limit    = UINT64_MAX,
+        .print          = 0
+    };
+
+    if (parse_args(argc, argv, &config) == 0)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    LoggerConfig logger_config = getDefaultLoggerConfig();
+    logger_config.out = LOG_OUTPUT_CONSOLE;
+    loggerInit(&logger_config);
+
+    Trace trace;
+    if (traceLoad(config.trace_path, &trace) == 0)
+    {
+        loggerTerminate();
+        return 1;
+    }
+
+    u64 cell_count = (u64)trace.rows * trace.cols;
+    if (trace.algo >= ALGO_COUNT || cell_count == 0 || trace.start >= cell_count || trace.goal >= cell_count)
+    {
+        fprintf(stderr, "Invalid trace header: %s\n", config.trace_path);
+        traceFree(&trace);
+        loggerTerminate();
+        return 1;
+    }
+
+    Replay replay = {
+        .parent     = malloc(cell_count * sizeof(u32)),
+        .expanded   = calloc(cell_count, sizeof(u8))
+    };
+
+    printf("trace %s: %s on %u x %u, %u-connected\n", config.trace_path, searchAlgoName(trace.algo),
+           trace.rows, trace.cols, trace.connectivity);
+    printf("start %u,%u  goal %u,%u\n", trace.start / trace.cols, trace.start % trace.cols,
+           trace.goal / trace.cols, trace.goal % trace.cols);
+    if (trace.recorded > trace.count)
+    {
+        printf("the first %lu of %lu events were dropped, the path may be cut short\n",
+               trace.recorded - trace.count, trace.recorded);
+    }
+
+    b8 valid = replay_events(&trace, &config, &replay);
+    if (valid == 1)
+    {
+        printf("events        %lu of %lu\n", replay.replayed, trace.count);
+        printf("push %lu  pop %lu  relax %lu  goal %lu\n", replay.counts[TRACE_PUSH], replay.counts[TRACE_POP],
+               replay.counts[TRACE_RELAX], replay.counts[TRACE_GOAL]);
+        printf("expanded      %lu\n", replay.expanded_count);
+        printf("stale pops    %lu\n", replay.stale_pops);
+
+        // BFS and DFS record no distances
+        b8 has_distance = trace.algo != ALGO_BFS && trace.algo != ALGO_DFS;
+
+        if (replay.found == 0)           printf("path          %s\n", replay.replayed < trace.recorded ? "not reached yet" : "not found");
+        else if (has_distance == 1)      printf("path          length %u, distance %u\n", replay.path_length, replay.goal_distance);
+        else                             printf("path          length %u\n", replay.path_length);
+    }
+
+    if (valid == 1 && config.map_path != NULL) valid = check_map(&trace, &config, &replay);
+
+    free(replay.parent);
+    free(replay.expanded);
+    traceFree(&trace);
+    landmarksDestroy();
+    traceDestroy();
+    gridDestroy();
+    loggerTerminate();
+
+    return valid == 1 ? 0 : 1;
+}
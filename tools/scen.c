@@ -0,0 +1,415 @@
+#include "logger.h"
+
+#include "grid.h"
+#include "map_io.h"
+#include "search.h"
+#include "priority_queue.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SCEN_MAX_ALGOS  ALGO_COUNT
+#define SCEN_NO_COST    UINT64_MAX
+
+typedef struct ScenConfig
+{
+    const char* scenario_path;
+    const char* map_path;       // NULL: the map named by the scenario
+    u32         algos[SCEN_MAX_ALGOS];
+    u32         algo_count;
+    const char* output;
+    u32         connectivity;
+    b8          verbose;
+} ScenConfig;
+
+// Outcome of one query for one algorithm
+typedef struct ScenRun
+{
+    u64     cost;               // SCEN_NO_COST when no path was found
+    u64     elapsed_ns;
+    u64     expanded;
+} ScenRun;
+
+static void
+print_usage(const char* program)
+{
+    fprintf(stderr,
+        "Usage: %s <file.scen> [options]\n"
+        "\n"
+        "Solves every query of a MovingAI scenario with each algorithm, checks the\n"
+        "path costs and reports latency percentiles and expansions per bucket.\n"
+        "\n"
+        "Options:\n"
+        "  --map <file>          map to use instead of the one the scenario names\n"
+        "  --algos <a,...>       algorithms to run (default: all that support the connectivity)\n"
+        "  --connectivity <n>    4 or 8, scenario lengths are only comparable with 8 (default: 8)\n"
+        "  --queue <name>        weighted search queue: heap, bucket, radix, dary or auto (default: auto)\n"
+        "  --threads <n>         threads of bfs-par and delta, 0 for one per core (default: 0)\n"
+        "  -v, --verbose         print every query whose result is wrong\n"
+        "  -o, --output <file>   write the per-bucket results as CSV\n",
+        program);
+}
+
+static b8
+parse_algos(const char* text, ScenConfig* config)
+{
+    char buffer[256];
+    strncpy(buffer, text, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+
+    config->algo_count = 0;
+    for (char* item = strtok(buffer, ","); item != NULL && config->algo_count < SCEN_MAX_ALGOS; item = strtok(NULL, ","))
+    {
+        SearchAlgo algo = searchAlgoFromName(item);
+        if (algo == ALGO_NONE)
+        {
+            fprintf(stderr, "Unknown algorithm: %s\n", item);
+            return 0;
+        }
+        config->algos[config->algo_count++] = algo;
+    }
+
+    return config->algo_count > 0;
+}
+
+static b8
+parse_args(int argc, char** argv, ScenConfig* config)
+{
+    if (argc < 2) return 0;
+    config->scenario_path = argv[1];
+
+    for (int i = 2; i < argc; ++i)
+    {
+        const char* option = argv[i];
+
+        if (strcmp(option, "-v") == 0 || strcmp(option, "--verbose") == 0)
+        {
+            config->verbose = 1;
+            continue;
+        }
+
+        const char* value = i + 1 < argc ? argv[++i] : NULL;
+        if (value == NULL) return 0;
+
+        if      (strcmp(option, "--map") == 0)          config->map_path = value;
+        else if (strcmp(option, "--algos") == 0)        { if (parse_algos(value, config) == 0) return 0; }
+        else if (strcmp(option, "--threads") == 0)      searchSetThreads((u32)strtoul(value, NULL, 10));
+        else if (strcmp(option, "--connectivity") == 0)
+        {
+            config->connectivity = (u32)strtoul(value, NULL, 10);
+            if (config->connectivity != GRID_CONNECT_4 && config->connectivity != GRID_CONNECT_8) return 0;
+        }
+        else if (strcmp(option, "-o") == 0 || strcmp(option, "--output") == 0) config->output = value;
+        else if (strcmp(option, "--queue") == 0)
+        {
+            if (strcmp(value, "auto") == 0) continue;
+
+            PriorityQueueKind queue = pqKindFromName(value);
+            if (queue == PQ_COUNT) return 0;
+            searchSetQueue(queue);
+        }
+        else return 0;
+    }
+
+    return 1;
+}
+
+// Scenarios name their map relative to a benchmark root: try it next to the
+// scenario, then the bare file name next to the scenario, then as given
+static b8
+load_map(const ScenConfig* config, const Scenario* scenario)
+{
+    if (config->map_path != NULL) return mapLoadAny(config->map_path);
+
+    char        path[1024];
+    const char* slash      = strrchr(config->scenario_path, '/');
+    int         dir_length = slash != NULL ? (int)(slash - config->scenario_path + 1) : 0;
+    const char* base_name  = strrchr(scenario->map_name, '/');
+    base_name              = base_name != NULL ? base_name + 1 : scenario->map_name;
+
+    const char* candidates[2] = { scenario->map_name, base_name };
+    for (u32 i = 0; i < 2; ++i)
+    {
+        snprintf(path, sizeof(path), "%.*s%s", dir_length, config->scenario_path, candidates[i]);
+
+        FILE* file = fopen(path, "r");
+        if (file == NULL) continue;
+        fclose(file);
+
+        return mapLoadAny(path);
+    }
+
+    return mapLoadAny(scenario->map_name);
+}
+
+// Algorithms that always return a shortest path on this grid. BFS counts
+// moves, which only matches the cost on unweighted 4-connected grids.
+static b8
+is_exact(SearchAlgo algo, const Grid* grid)
+{
+    switch (algo)
+    {
+        case ALGO_DFS:
+        case ALGO_HPA:              return 0;
+        case ALGO_BFS:
+        case ALGO_BFS_BIDIR:
+        case ALGO_BFS_PARALLEL:     return grid->max_weight == 1 && grid->connectivity == GRID_CONNECT_4;
+        default:                    return 1;
+    }
+}
+
+// Wrong: a different reachability, a path cheaper than the optimum,
+// or a longer one from an algorithm that should be exact
+static b8
+is_wrong(const ScenRun* run, const ScenRun* reference, b8 exact)
+{
+    return (run->cost == SCEN_NO_COST) != (reference->cost == SCEN_NO_COST) ||
+           run->cost < reference->cost ||
+           (exact == 1 && run->cost != reference->cost);
+}
+
+static ScenRun
+run_query(SearchAlgo algo, const ScenarioEntry* entry)
+{
+    gridSetStart(entry->start_y, entry->start_x);
+    gridSetGoal(entry->goal_y, entry->goal_x);
+
+    SearchResult result = searchRun(algo);
+
+    return (ScenRun){
+        .cost       = result.found ? result.path_cost : SCEN_NO_COST,
+        .elapsed_ns = result.elapsed_ns,
+        .expanded   = result.stats.expanded
+    };
+}
+
+static int
+compare_u64(const void* a, const void* b)
+{
+    u64 x = *(const u64*)a;
+    u64 y = *(const u64*)b;
+
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted values: the smallest one that at least
+// percent% of the values do not exceed
+static double
+percentile_us(const u64* sorted, u64 count, u32 percent)
+{
+    u64 rank = (count * percent + 99) / 100;
+
+    return sorted[rank > 0 ? rank - 1 : 0] / 1e3;
+}
+
+int main(int argc, char** argv)
+{
+    ScenConfig config = {
+        .map_path   = NULL,
+        .algo_count = 0,
+        .output       = NULL,
+        .connectivity = GRID_CONNECT_8,
+        .verbose      = 0
+    };
+
+    if (parse_args(argc, argv, &config) == 0)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    LoggerConfig logger_config = getDefaultLoggerConfig();
+    logger_config.out = LOG_OUTPUT_CONSOLE;
+    loggerInit(&logger_config);
+
+    Scenario scenario;
+    if (scenarioLoad(config.scenario_path, &scenario) == 0 || scenario.count == 0)
+    {
+        fprintf(stderr, "No queries in %s\n", config.scenario_path);
+        loggerTerminate();
+        return 1;
+    }
+
+    if (load_map(&config, &scenario) == 0)
+    {
+        fprintf(stderr, "Could not load the map %s\n", config.map_path != NULL ? config.map_path : scenario.map_name);
+        scenarioDestroy(&scenario);
+        loggerTerminate();
+        return 1;
+    }
+
+    gridSetConnectivity(config.connectivity);
+
+    Grid* grid = gridGet();
+    u32   max_bucket = 0;
+
+    // By default, the algorithms that run as themselves on this grid
+    if (config.algo_count == 0)
+    {
+        for (u32 algo = ALGO_NONE + 1; algo < ALGO_COUNT; ++algo)
+        {
+            if (searchResolveAlgo(algo) == algo) config.algos[config.algo_count++] = algo;
+        }
+    }
+
+    for (u64 i = 0; i < scenario.count; ++i)
+    {
+        const ScenarioEntry* entry = &scenario.entries[i];
+
+        if (entry->map_width != grid->cols || entry->map_height != grid->rows ||
+            entry->start_x >= grid->cols || entry->goal_x >= grid->cols ||
+            entry->start_y >= grid->rows || entry->goal_y >= grid->rows)
+        {
+            fprintf(stderr, "Query %lu does not fit the %u x %u map\n", i + 1, grid->cols, grid->rows);
+            gridDestroy();
+            scenarioDestroy(&scenario);
+            loggerTerminate();
+            return 1;
+        }
+
+        if (entry->bucket > max_bucket) max_bucket = entry->bucket;
+    }
+
+    // Reference costs from Dijkstra. 8-connected, they must equal the
+    // scenario's optimal lengths. 4-connected, every path is also a path with
+    // diagonal moves, so they can only be longer. Otherwise the map and the
+    // scenario do not match.
+    double   unit       = config.connectivity == GRID_CONNECT_8 ? GRID_COST_STRAIGHT : 1.0;
+    ScenRun* reference  = malloc(scenario.count * sizeof(ScenRun));
+    u64      mismatched = 0;
+    double   ratio_sum  = 0.0;
+    u64      ratio_count = 0;
+
+    for (u64 i = 0; i < scenario.count; ++i)
+    {
+        const ScenarioEntry* entry = &scenario.entries[i];
+
+        reference[i] = run_query(ALGO_DIJKSTRA, entry);
+
+        double length  = reference[i].cost / unit;
+        double optimal = entry->optimal_length;
+        double error   = length > optimal ? length - optimal : optimal - length;
+        b8     matches = config.connectivity == GRID_CONNECT_8 ? error <= 1e-5 * optimal + 1e-3
+                                                               : length + 1e-4 >= optimal;
+
+        if (reference[i].cost == SCEN_NO_COST || matches == 0)
+        {
+            mismatched += 1;
+            if (config.verbose == 1) fprintf(stderr, "Query %lu: reference does not match the scenario\n", i + 1);
+        }
+        else if (entry->optimal_length > 0)
+        {
+            ratio_sum   += length / optimal;
+            ratio_count += 1;
+        }
+    }
+
+    printf("scenario %s: %lu queries on %u x %u\n", config.scenario_path, scenario.count, grid->cols, grid->rows);
+    printf("%u-connected optimum / scenario optimum: %.5f on average, %lu queries do not match\n",
+           config.connectivity, ratio_count > 0 ? ratio_sum / ratio_count : 0.0, mismatched);
+
+    FILE* csv = NULL;
+    if (config.output != NULL)
+    {
+        csv = fopen(config.output, "w");
+        if (csv == NULL) fprintf(stderr, "Could not open %s\n", config.output);
+    }
+
+    if (csv != NULL)
+    {
+        fprintf(csv, "algorithm,bucket,queries,found,wrong,excess_pct,p50_us,p95_us,p99_us,max_us,mean_expanded\n");
+    }
+
+    printf("%-12s %6s %7s %7s %6s %8s %10s %10s %10s %10s %12s\n", "algorithm", "bucket", "queries", "found",
+           "wrong", "excess", "p50_us", "p95_us", "p99_us", "max_us", "expanded");
+
+    ScenRun* runs      = malloc(scenario.count * sizeof(ScenRun));
+    u64*     latencies = malloc(scenario.count * sizeof(u64));
+    u64      failures  = 0;
+
+    for (u32 a = 0; a < config.algo_count; ++a)
+    {
+        SearchAlgo algo  = config.algos[a];
+        b8         exact = is_exact(searchResolveAlgo(algo), grid);
+
+        if (searchResolveAlgo(algo) != algo)
+        {
+            fprintf(stderr, "%s runs as %s on this grid\n", searchAlgoName(algo), searchAlgoName(searchResolveAlgo(algo)));
+        }
+
+        for (u64 i = 0; i < scenario.count; ++i)
+        {
+            runs[i] = run_query(algo, &scenario.entries[i]);
+
+            if (is_wrong(&runs[i], &reference[i], exact) == 1 && config.verbose == 1)
+            {
+                const ScenarioEntry* entry = &scenario.entries[i];
+                fprintf(stderr, "%s: query %lu (%u,%u) -> (%u,%u) cost %lu, expected %lu\n", searchAlgoName(algo),
+                        i + 1, entry->start_x, entry->start_y, entry->goal_x, entry->goal_y,
+                        runs[i].cost, reference[i].cost);
+            }
+        }
+
+        for (u32 bucket = 0; bucket <= max_bucket; ++bucket)
+        {
+            u64    count      = 0;
+            u64    found      = 0;
+            u64    wrong      = 0;
+            u64    expanded   = 0;
+            double excess_sum = 0.0;
+
+            for (u64 i = 0; i < scenario.count; ++i)
+            {
+                if (scenario.entries[i].bucket != bucket) continue;
+
+                b8 has_path = runs[i].cost != SCEN_NO_COST;
+                b8 has_ref  = reference[i].cost != SCEN_NO_COST;
+
+                latencies[count++]  = runs[i].elapsed_ns;
+                found              += has_path;
+                wrong              += is_wrong(&runs[i], &reference[i], exact);
+                expanded           += runs[i].expanded;
+
+                if (has_path == 1 && has_ref == 1 && reference[i].cost > 0)
+                {
+                    excess_sum += 100.0 * ((double)runs[i].cost - reference[i].cost) / reference[i].cost;
+                }
+            }
+
+            if (count == 0) continue;
+
+            qsort(latencies, count, sizeof(u64), compare_u64);
+
+            double excess = found > 0 ? excess_sum / found : 0.0;
+            double p50    = percentile_us(latencies, count, 50);
+            double p95    = percentile_us(latencies, count, 95);
+            double p99    = percentile_us(latencies, count, 99);
+            double max    = latencies[count - 1] / 1e3;
+
+            failures += wrong;
+
+            printf("%-12s %6u %7lu %7lu %6lu %7.2f%% %10.1f %10.1f %10.1f %10.1f %12.0f\n", searchAlgoName(algo),
+                   bucket, count, found, wrong, excess, p50, p95, p99, max, (double)expanded / count);
+
+            if (csv != NULL)
+            {
+                fprintf(csv, "%s,%u,%lu,%lu,%lu,%.3f,%.3f,%.3f,%.3f,%.3f,%.1f\n", searchAlgoName(algo), bucket,
+                        count, found, wrong, excess, p50, p95, p99, max, (double)expanded / count);
+            }
+        }
+    }
+
+    printf("%lu wrong results\n", failures);
+
+    if (csv != NULL) fclose(csv);
+
+    free(latencies);
+    free(runs);
+    free(reference);
+    gridDestroy();
+    scenarioDestroy(&scenario);
+    loggerTerminate();
+
+    return failures > 0 || mismatched > 0 ? 2 : 0;
+}